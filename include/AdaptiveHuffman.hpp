@@ -0,0 +1,69 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_ADAPTIVEHUFFMAN_HPP
+#define HUFFZIP_ADAPTIVEHUFFMAN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "BitStream.hpp"
+
+/*
+ * AdaptiveHuffman功能（FGK 算法）
+ * 1. 编码器和解码器从只含 NYT（尚未出现）节点的树出发，每个符号编解码后同步更新模型
+ * 2. 不需要预先统计频率，也不传输编码表，数据到达后即可编码输出
+ * 3. 节点存放在按编号排列的定长数组中，编号越大权重越大（兄弟性质），更新时只交换数组元素
+ * 4. 字母表为 256 个字节值加 FLUSH、END 两个控制符号
+ */
+class AdaptiveHuffman {
+public:
+    static const unsigned SYMBOL_COUNT = 258;
+    static const unsigned FLUSH_SYMBOL = 256;  // 刷新点：其后位流补齐到字节边界
+    static const unsigned END_SYMBOL = 257;    // 数据结束
+    static const unsigned SYMBOL_BITS = 9;     // 新符号跟在 NYT 编码之后的原始位数
+
+    AdaptiveHuffman();
+
+    // 编码一个符号并更新模型
+    void encode(unsigned symbol, BitStream& bitStream);
+
+    // 解码一个符号并更新模型
+    unsigned decode(BitStream& bitStream);
+
+    // 恢复到初始状态
+    void reset();
+
+private:
+    static const int MAX_NODES = 2 * SYMBOL_COUNT + 1;  // 全部符号出现后的叶子、内部节点和 NYT
+    static const int ROOT = MAX_NODES - 1;
+    static const int NO_NODE = -1;
+
+    // 数组下标即节点编号；叶子的 left 为 NO_NODE，symbol 为字节值或控制符号
+    struct Node {
+        uint64_t weight;
+        int parent;
+        int left;
+        int right;
+        int symbol;
+    };
+
+    Node nodes_[MAX_NODES];
+    int leafOf_[SYMBOL_COUNT];  // 符号对应的叶子编号，未出现为 NO_NODE
+    int nyt_;                   // NYT 叶子编号
+    int nextFree_;              // 下一个可分配的编号（向下递减）
+
+    // 把 node 到根的路径按从根到叶的顺序写入位流
+    void writePath(int node, BitStream& bitStream) const;
+
+    // 拆分 NYT 为新的 NYT 和 symbol 的叶子，返回新叶子编号
+    int addSymbol(unsigned symbol);
+
+    // 符号出现一次后的更新：沿路径上行，先与同权重编号最大的节点交换再加权
+    void update(int node);
+
+    // 交换两个节点在编号中的位置（两者的父节点保持不变）
+    void swapNodes(int a, int b);
+};
+
+#endif //HUFFZIP_ADAPTIVEHUFFMAN_HPP
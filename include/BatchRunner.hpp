@@ -0,0 +1,60 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_BATCHRUNNER_HPP
+#define HUFFZIP_BATCHRUNNER_HPP
+
+#include "HuffmanCompressor.hpp"
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/*
+ * BatchRunner功能
+ * 1. 在一个进程内执行任务列表中的全部任务，每行一个任务："<命令>\t<输入>\t<输出>"
+ *    （没有制表符时按空白分隔），空行和 # 开头的行忽略
+ * 2. 固定数量的工作线程按顺序领取任务，每个线程复用同一个 HuffmanCompressor
+ * 3. 单个任务失败不影响其他任务，最后按任务列表顺序输出每个任务的状态和统计信息
+ */
+class BatchRunner {
+public:
+    static const size_t MAX_WORKERS = 8;
+
+    // workerCount 为 0 时按 CPU 核数选择
+    explicit BatchRunner(const HuffmanCompressor::CompressionOptions& options, size_t workerCount = 0);
+
+    // 以下设置应用到每个工作线程的压缩器
+    void setStatsFormat(HuffmanCompressor::StatsFormat format);
+    void setSyncOutput(bool enabled);
+    void setContentHash(bool enabled);
+    void setFlushInterval(size_t bytes);
+
+    // 执行 jobList 中的任务并把汇总写入 summary，全部成功时返回 true
+    bool run(std::istream& jobList, std::ostream& summary);
+
+private:
+    HuffmanCompressor::CompressionOptions options_;
+    size_t workerCount_;
+    HuffmanCompressor::StatsFormat statsFormat_;
+    bool syncOutput_;
+    bool contentHash_;
+    size_t flushInterval_;
+
+    // 一个任务及其结果
+    struct Job {
+        size_t line;        // 在任务列表中的行号
+        std::string command;
+        std::string input;
+        std::string output;
+        bool succeeded;
+        std::string error;
+        HuffmanCompressor::CompressionStats stats;
+    };
+
+    static std::vector<Job> parseJobs(std::istream& jobList);
+    void printSummary(const std::vector<Job>& jobs, double totalTime, std::ostream& summary) const;
+};
+
+#endif //HUFFZIP_BATCHRUNNER_HPP
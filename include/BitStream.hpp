@@ -8,6 +8,9 @@
 #include <string>
 #include <fstream>
 #include <cstdint>
+#include "BlockWriter.hpp"
+
+class BlockReader;
 
 class BitStream {
 public:
@@ -19,6 +22,13 @@ public:
     // 构造函数
     BitStream(const std::string& filePath, Mode mode);
 
+    // 构造函数：基于流水线读写器（读/写模式由参数类型决定）
+    explicit BitStream(BlockReader& reader);
+    explicit BitStream(BlockWriter& writer);
+
+    // 构造函数：从内存中的完整数据读取（数据须在 BitStream 使用期间有效）
+    BitStream(const uint8_t* data, size_t size);
+
     // 析构函数
     ~BitStream();
 
@@ -34,24 +44,94 @@ public:
     void writeByte(uint8_t byte);
     uint8_t readByte();
 
+    // 读模式下按字节读取 size 字节（调用前须已对齐到字节）
+    void readBytes(uint8_t* data, size_t size);
+
     // 缓冲区管理
     void flush();
     size_t getPendingBits() const;
 
+    // 读模式下丢弃当前字节的剩余位，对齐到下一个字节
+    void alignToByte();
+
+    // 64 位缓冲区写入前或装满后可用的最少位数（未满一字节的残留最多 7 位），
+    // 查表编码和解码的码长不超过它时每个码字只需一次写入或一次 refill()
+    static const unsigned MAX_FAST_CODE_LENGTH = 57;
+
+    // 批量写入接口（供查表编码使用）：写入 code 的低 length 位，高位在前
+    // length 为 1..MAX_FAST_CODE_LENGTH，code 中 length 位以上必须为 0
+    void writeBits(uint64_t code, unsigned length) {
+        if (bitCount_ + length > 64) {
+            drainBytes();
+        }
+        bitBuffer_ |= code << (64 - bitCount_ - length);
+        bitCount_ += length;
+    }
+
+    // 批量读取接口（供查表解码使用）
+    // 位缓冲区高位对齐：peekBits() 的最高位是下一个待读的位
+    // refill() 之后至少有 MAX_FAST_CODE_LENGTH 位可用，除非已接近数据末尾
+    void refill() {
+        if (bitCount_ <= 56 && readEnd_ - readPtr_ >= 8) {
+            // 一次装入 8 字节，只消费能完整放入缓冲区的字节数
+            uint64_t value = 0;
+            for (int i = 0; i < 8; ++i) {
+                value = (value << 8) | readPtr_[i];
+            }
+            unsigned bytes = (64 - bitCount_) >> 3;
+            unsigned newCount = bitCount_ + bytes * 8;
+            bitBuffer_ |= (value >> bitCount_) & (~0ULL << (64 - newCount));
+            bitCount_ = newCount;
+            readPtr_ += bytes;
+            return;
+        }
+        refillSlow();
+    }
+    uint64_t peekBits() const { return bitBuffer_; }
+    unsigned bitsAvailable() const { return bitCount_; }
+    void consumeBits(unsigned count) {
+        bitBuffer_ <<= count;
+        bitCount_ -= count;
+    }
+
     // 文件操作
     void close();
+
+    // 已读完所有数据（在读取尝试之后才能确定）
     bool isEOF() const;
 
 private:
     std::fstream fileStream_;
     Mode mode_;
-    uint8_t buffer_;
-    size_t bitPosition_;
     bool isOpen_;
 
+    // 64 位缓冲区，高位对齐，按整字节与底层读写
+    uint64_t bitBuffer_;
+    unsigned bitCount_;
+
+    // 流水线读写器（为空时使用 fileStream_）
+    BlockReader* reader_;
+    BlockWriter* writer_;
+    const uint8_t* readPtr_;
+    const uint8_t* readEnd_;
+    bool sourceEOF_;
+
     // 辅助方法
-    void writeBuffer();
-    void readBuffer();
+    void refillSlow();
+
+    // 把缓冲区中的整字节交给底层输出
+    void drainBytes() {
+        if (writer_) {
+            while (bitCount_ >= 8) {
+                writer_->put(static_cast<uint8_t>(bitBuffer_ >> 56));
+                bitBuffer_ <<= 8;
+                bitCount_ -= 8;
+            }
+            return;
+        }
+        drainToFile();
+    }
+    void drainToFile();
 };
 
 #endif // BIT_STREAM_HPP
\ No newline at end of file
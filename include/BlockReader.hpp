@@ -0,0 +1,103 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_BLOCKREADER_HPP
+#define HUFFZIP_BLOCKREADER_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+class VolumeSet;
+
+/*
+ * BlockReader功能
+ * 1. 后台读线程按块预读文件，填充固定大小的环形缓冲区
+ * 2. 调用线程处理当前块时，下一块的读取已在进行（I/O 与计算重叠）
+ * 3. 缓冲区在读线程与调用线程之间循环复用，不再额外分配内存
+ * 4. ringSize 为 0 时不启动读线程，next() 在调用线程中读一次，返回当前已到达的数据（用于管道等流式输入）
+ * 5. 也可从分卷归档的指定偏移处读取，跨卷时自动接续
+ */
+class BlockReader {
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;  // 1 MiB
+    static const size_t DEFAULT_RING_SIZE = 4;
+
+    // 构造函数：从 offset 处开始读取文件
+    BlockReader(const std::string& filePath, uint64_t offset = 0,
+                size_t blockSize = DEFAULT_BLOCK_SIZE, size_t ringSize = DEFAULT_RING_SIZE);
+
+    // 构造函数：从分卷归档的 offset 处开始读取（不支持流式读取），volumes 须在读取期间有效
+    BlockReader(const VolumeSet& volumes, uint64_t offset,
+                size_t blockSize = DEFAULT_BLOCK_SIZE, size_t ringSize = DEFAULT_RING_SIZE);
+
+    // 析构函数
+    ~BlockReader();
+
+    // 禁止拷贝
+    BlockReader(const BlockReader&) = delete;
+    BlockReader& operator=(const BlockReader&) = delete;
+
+    // 获取下一个数据块，返回 false 表示已读完
+    // 上一次返回的块在本次调用时归还给读线程
+    bool next(const uint8_t*& data, size_t& size);
+
+    // 停止读线程并关闭文件
+    void close();
+
+    // 是否为流式读取（ringSize 为 0）
+    bool isStreaming() const;
+
+    uint64_t getBytesRead() const;
+    uint64_t getBlocksRead() const;
+
+    // 调用线程在 next() 中等待数据的累计时间（秒）
+    double getWaitTime() const;
+
+    // 读线程执行读取的累计时间（秒）
+    double getBusyTime() const;
+
+private:
+    struct Slot {
+        std::vector<uint8_t> data;
+        size_t size;
+    };
+
+    std::ifstream fileStream_;
+    int fd_;                // 流式读取使用的文件描述符
+    const VolumeSet* volumes_;  // 从分卷归档读取时非空
+    uint64_t volumeOffset_;     // 分卷归档中下一次读取的偏移
+    bool streaming_;
+    std::vector<Slot> ring_;
+    size_t blockSize_;
+    size_t fillIndex_;      // 读线程下一个要填充的槽
+    size_t consumeIndex_;   // 调用线程下一个要取走的槽
+    size_t filled_;         // 已填充、等待取走的槽数
+    bool holding_;          // 调用线程是否持有一个槽
+    bool eof_;
+    bool stop_;
+    uint64_t bytesRead_;
+    uint64_t blocksRead_;
+    double waitTime_;
+    double busyTime_;
+    std::exception_ptr error_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::thread thread_;
+
+    // 读线程主循环
+    void run();
+
+    // 流式模式下的 next()
+    bool nextStreaming(const uint8_t*& data, size_t& size);
+};
+
+#endif //HUFFZIP_BLOCKREADER_HPP
@@ -0,0 +1,157 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_BLOCKWRITER_HPP
+#define HUFFZIP_BLOCKWRITER_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+/*
+ * BlockWriter功能
+ * 1. 调用线程把输出写入当前缓冲块，写满后提交给后台写线程
+ * 2. 写线程按提交顺序把缓冲块落盘，调用线程继续编码下一块
+ * 3. 固定数量的缓冲块循环复用，写线程落后时调用线程等待
+ * 4. ringSize 为 0 时不启动写线程，缓冲块写满后在调用线程中直接写入（用于大量小文件）
+ * 5. 分卷模式下按卷大小把输出依次切分写入各卷，写满一卷后关闭并打开下一卷
+ */
+class BlockWriter {
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;  // 1 MiB
+    static const size_t DEFAULT_RING_SIZE = 4;
+    static const size_t MIN_KERNEL_COPY = 64 << 10;    // 更短的复制直接读入缓冲块，不值得等待写队列清空
+    static const size_t MAX_KERNEL_COPY = 1 << 30;     // 单次复制系统调用的最大字节数
+
+    enum class OpenMode {
+        TRUNCATE,   // 新建或截断文件，从头写入
+        OVERWRITE   // 打开已有文件，从指定偏移处覆盖写入，完成时截断到写入末尾
+    };
+
+    // 构造函数：新建或截断文件
+    BlockWriter(const std::string& filePath,
+                size_t blockSize = DEFAULT_BLOCK_SIZE, size_t ringSize = DEFAULT_RING_SIZE);
+
+    // 构造函数：按指定模式打开文件，从 offset 处开始写入
+    BlockWriter(const std::string& filePath, OpenMode mode, uint64_t offset,
+                size_t blockSize = DEFAULT_BLOCK_SIZE, size_t ringSize = DEFAULT_RING_SIZE);
+
+    // 构造函数：分卷写入，每卷 volumeSize 字节，卷路径见 VolumeSet::volumePath
+    BlockWriter(const std::string& archivePath, const std::vector<std::string>& volumeDirs, uint64_t volumeSize,
+                size_t blockSize = DEFAULT_BLOCK_SIZE, size_t ringSize = DEFAULT_RING_SIZE);
+
+    // 析构函数
+    ~BlockWriter();
+
+    // 禁止拷贝
+    BlockWriter(const BlockWriter&) = delete;
+    BlockWriter& operator=(const BlockWriter&) = delete;
+
+    // 写入任意长度的数据
+    void write(const void* data, size_t size);
+
+    // 写入单个字节（热路径，内联）
+    void put(uint8_t byte) {
+        if (currentSize_ == blockSize_) {
+            submit();
+        }
+        current_[currentSize_++] = byte;
+    }
+
+    // 按预计大小预先分配磁盘空间（不改变文件长度，不支持时忽略）
+    void preallocate(uint64_t size);
+
+    // 关闭前是否调用 fsync 确保数据落盘（默认不调用）
+    void setSync(bool sync);
+
+    // 把已写入的数据交给文件并等待写完（流式输出的刷新点），不关闭文件
+    void flush();
+
+    // 把 sourceFd 中 offset 处的 size 个字节接在已写入的数据之后
+    // 不短于 MIN_KERNEL_COPY 且内核支持时由 copy_file_range / sendfile 在文件间直接复制
+    // （同一文件系统上可能只共享数据块），否则经缓冲块复制
+    void copyFrom(int sourceFd, uint64_t offset, uint64_t size);
+
+    // 分卷模式下保证接下来的 size 个字节落在同一卷中：当前卷剩余空间不足、而整卷放得下时换到新卷
+    void keepTogether(uint64_t size);
+
+    // 提交剩余数据，等待写线程落盘并关闭文件
+    void finish();
+
+    uint64_t getBytesWritten() const;
+
+    // 当前写入位置在文件中的绝对偏移
+    uint64_t getPosition() const;
+
+    // 调用线程等待空闲缓冲块的累计时间（秒）
+    double getWaitTime() const;
+
+    // 写线程执行写入的累计时间（秒）
+    double getBusyTime() const;
+
+private:
+    struct Slot {
+        std::vector<uint8_t> data;
+        size_t size;
+    };
+
+    int fd_;
+    std::string filePath_;
+    OpenMode mode_;
+    uint64_t startOffset_;
+    std::vector<Slot> ring_;
+    size_t blockSize_;
+    uint8_t* current_;      // 调用线程正在填充的缓冲区
+    size_t currentSize_;
+    size_t fillIndex_;      // 调用线程持有的槽
+    size_t drainIndex_;     // 写线程下一个要落盘的槽
+    size_t pending_;        // 已提交、等待落盘的槽数
+    bool done_;
+    bool finished_;
+    bool synchronous_;      // 不使用写线程
+    bool sync_;
+    uint64_t bytesSubmitted_;
+    double waitTime_;
+    double busyTime_;
+    std::exception_ptr error_;
+
+    // 分卷写入（volumeSize_ 为 0 时不分卷）
+    uint64_t volumeSize_;
+    std::string archivePath_;
+    std::vector<std::string> volumeDirs_;
+    size_t volumeIndex_;                  // 当前卷号，从 1 开始
+    uint64_t volumeWritten_;              // 当前卷已写入的字节数
+
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::thread thread_;
+
+    // 提交当前缓冲块并切换到下一个空闲槽
+    void submit();
+
+    // 把一个缓冲块写入文件
+    void writeSlot(const Slot& slot);
+
+    // 由内核在文件间复制，返回未能复制的字节数（系统调用不支持时原样返回）
+    uint64_t kernelCopy(int sourceFd, uint64_t offset, uint64_t size);
+
+    // 写线程主循环
+    void run();
+
+    // 打开第 volumeIndex_ 个卷
+    void openVolume();
+
+    // 关闭写满的当前卷，打开下一个卷
+    void nextVolume();
+
+    // 删除之前写入同名归档时留下的、不属于本次输出的卷
+    void removeStaleVolumes();
+};
+
+#endif //HUFFZIP_BLOCKWRITER_HPP
@@ -0,0 +1,37 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_BYTEORDER_HPP
+#define HUFFZIP_BYTEORDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 归档中的多字节整数一律按小端序存储，与主机字节序无关
+
+// 把 value 的低 bytes 个字节按小端序写入 p
+inline void storeLE(uint8_t* p, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+// 从 p 读取 bytes 个字节的小端序整数
+inline uint64_t loadLE(const uint8_t* p, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(p[i]) << (i * 8);
+    }
+    return value;
+}
+
+// 把 value 的低 bytes 个字节按小端序追加到 data 末尾
+inline void appendLE(std::vector<uint8_t>& data, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        data.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+#endif //HUFFZIP_BYTEORDER_HPP
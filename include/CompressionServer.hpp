@@ -0,0 +1,75 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_COMPRESSIONSERVER_HPP
+#define HUFFZIP_COMPRESSIONSERVER_HPP
+
+#include "HuffmanCompressor.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * CompressionServer功能
+ * 1. 监听 Unix 域套接字，每个连接是一个请求，由常驻的工作线程处理，省去进程启动和线程创建
+ * 2. 每个工作线程持有自己的 HuffmanCompressor 和内联数据缓冲文件，在请求之间复用
+ * 3. 输入输出可以是服务端路径、随请求通过 SCM_RIGHTS 传来的文件描述符，或在连接上内联传输的数据
+ *
+ * 请求：一行 "<命令>\t<输入>\t<输出>[\t<文件名>]\n"，命令与命令行相同（compress-file、compress-dir、decompress、
+ *       compress-stream、decompress-stream），另有 "shutdown" 处理完已接受的连接后退出
+ *       输入或输出为 "-" 时依次取随请求传来的描述符；没有描述符时输入为请求行之后直到
+ *       客户端关闭写端的全部数据，输出随响应返回
+ *       文件名为单文件归档中记录的文件名（不含 /），输入为 "-" 且未给出时为 stdin
+ *       decompress 的输出为 "-" 时写出单文件归档的唯一成员，目录归档返回 ERROR
+ * 响应：一行 "OK <内联输出字节数> <JSON 统计信息>\n" 后跟内联输出，或 "ERROR <原因>\n"
+ */
+class CompressionServer {
+public:
+    static const size_t MAX_WORKERS = 8;
+    static const size_t MAX_REQUEST_LINE = 64 << 10;  // 请求行（含路径）的最大长度
+    static const size_t MAX_PASSED_FDS = 2;           // 每个请求最多传来输入、输出两个描述符
+    static const int LISTEN_BACKLOG = 128;
+
+    // workerCount 为 0 时按 CPU 核数选择
+    explicit CompressionServer(const HuffmanCompressor::CompressionOptions& options, size_t workerCount = 0);
+
+    // 以下设置应用到每个工作线程的压缩器
+    void setSyncOutput(bool enabled);
+    void setContentHash(bool enabled);
+    void setFlushInterval(size_t bytes);
+
+    // 在 socketPath 上监听并处理请求，直到收到 shutdown 请求
+    void serve(const std::string& socketPath);
+
+private:
+    HuffmanCompressor::CompressionOptions options_;
+    size_t workerCount_;
+    bool syncOutput_;
+    bool contentHash_;
+    size_t flushInterval_;
+
+    // 监听线程与工作线程共享的连接队列
+    int listenFd_;
+    bool stopping_;
+    std::deque<int> pendingConnections_;
+    std::mutex mutex_;
+    std::condition_variable hasWork_;
+
+    // 工作线程复用的状态
+    struct Worker {
+        HuffmanCompressor compressor;
+        int inlineInput;   // 内联输入的暂存文件（已删除目录项）
+        int inlineOutput;  // 内联输出的暂存文件
+        std::vector<uint8_t> buffer;
+    };
+
+    void run();
+    void handleConnection(Worker& worker, int connection);
+    void stop();
+};
+
+#endif //HUFFZIP_COMPRESSIONSERVER_HPP
@@ -0,0 +1,40 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_CONTENTHASHER_HPP
+#define HUFFZIP_CONTENTHASHER_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * ContentHasher功能
+ * 1. 流式计算 64 位内容哈希（XXH64 算法），每次 update 可传入任意长度数据
+ * 2. 用于判断文件内容是否变化，不用于安全场景
+ */
+class ContentHasher {
+public:
+    explicit ContentHasher(uint64_t seed = 0);
+
+    // 追加数据
+    void update(const void* data, size_t size);
+
+    // 计算当前哈希值（不影响后续 update）
+    uint64_t digest() const;
+
+    // 计算整个文件的哈希
+    static uint64_t hashFile(const std::string& filePath);
+
+private:
+    uint64_t seed_;
+    uint64_t accumulators_[4];
+    uint8_t buffer_[32];     // 不足 32 字节的尾部数据
+    size_t bufferSize_;
+    uint64_t totalLength_;
+
+    void processStripe(const uint8_t* stripe);
+};
+
+#endif //HUFFZIP_CONTENTHASHER_HPP
@@ -0,0 +1,45 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_CPUDISPATCH_HPP
+#define HUFFZIP_CPUDISPATCH_HPP
+
+#include <string>
+#include "Kernels.hpp"
+
+/*
+ * CpuDispatch功能
+ * 1. 启动时通过 cpuid 检测 CPU 支持的指令集
+ * 2. 选择对应指令集编译的内核（频率统计、内容哈希、编码、解码）
+ * 3. 支持强制指定指令集，便于在同一台机器上测试所有版本
+ */
+class CpuDispatch {
+public:
+    enum class Isa {
+        SCALAR,   // 不使用扩展指令集
+        SSE42,
+        AVX2,     // AVX2 + BMI2
+        AVX512    // AVX-512F/BW
+    };
+
+    // 当前 CPU 支持的最高指令集
+    static Isa detectIsa();
+
+    // 当前 CPU 是否支持指定指令集
+    static bool isSupported(Isa isa);
+
+    // 当前使用的指令集（未强制指定时为 detectIsa() 的结果）
+    static Isa getActiveIsa();
+
+    // 强制使用指定指令集（scalar / sse4.2 / avx2 / avx512）
+    // 名称无效或 CPU 不支持时抛出异常
+    static void forceIsa(const std::string& name);
+
+    static std::string isaName(Isa isa);
+
+    // 当前指令集对应的内核
+    static const Kernels& getKernels();
+};
+
+#endif //HUFFZIP_CPUDISPATCH_HPP
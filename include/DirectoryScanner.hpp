@@ -0,0 +1,54 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_DIRECTORYSCANNER_HPP
+#define HUFFZIP_DIRECTORYSCANNER_HPP
+
+#include "FileEntry.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * DirectoryScanner功能
+ * 1. 多个线程并行遍历子目录，每个目录打开一次后批量读取目录项
+ * 2. 目录项的类型、大小、修改时间一次 statx 取得，相对路径由父目录前缀直接拼接
+ * 3. 结果按相对路径排序，父目录总在其内容之前，输出与线程调度无关
+ */
+class DirectoryScanner {
+public:
+    static const size_t MAX_THREADS = 8;  // 元数据操作受限于文件系统，更多线程收益不大
+
+    // threadCount 为 0 时按 CPU 核数选择
+    explicit DirectoryScanner(size_t threadCount = 0);
+
+    // 扫描 rootPath 下的所有文件和目录（不含 rootPath 本身）
+    std::vector<FileEntry> scan(const std::string& rootPath);
+
+    // 单个路径的修改时间（Unix 纪元起的纳秒数）
+    static int64_t modifiedTime(const std::string& path);
+
+private:
+    size_t threadCount_;
+
+    // 扫描过程中的共享状态
+    std::string rootPath_;
+    int rootFd_;
+    std::deque<std::string> pendingDirs_;  // 待扫描目录的相对路径（根目录为空串）
+    size_t activeDirs_;                    // 已入队或正在扫描的目录数
+    std::mutex mutex_;
+    std::condition_variable hasWork_;
+    std::vector<std::vector<FileEntry>> results_;  // 每个线程各自收集
+    std::exception_ptr error_;
+
+    void run(size_t worker);
+    void scanDirectory(const std::string& relativeDir, std::vector<FileEntry>& entries,
+                       std::vector<std::string>& subdirs);
+};
+
+#endif //HUFFZIP_DIRECTORYSCANNER_HPP
@@ -0,0 +1,73 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_DUPLICATEFINDER_HPP
+#define HUFFZIP_DUPLICATEFINDER_HPP
+
+#include "FileEntry.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * DuplicateFinder功能
+ * 1. 后台哈希线程按编码顺序计算各文件的内容哈希（XXH64），与调用线程的编码并行
+ * 2. 大小和哈希都与之前某个文件相同时再逐字节比较，一致才判为重复，哈希碰撞不会导致数据错误
+ * 3. 每组相同内容中顺序最靠前的文件照常编码，其余文件的条目直接引用它的数据
+ * 4. 已记录内容哈希的条目（--hash）不再重新计算
+ */
+class DuplicateFinder {
+public:
+    static const size_t READ_CHUNK_SIZE = 1 << 20;
+
+    // files 为按编码顺序排列的非空文件，开始在后台计算哈希
+    DuplicateFinder(const std::string& baseDir, const std::vector<FileEntry*>& files);
+
+    // 提前结束时停止哈希线程
+    ~DuplicateFinder();
+
+    DuplicateFinder(const DuplicateFinder&) = delete;
+    DuplicateFinder& operator=(const DuplicateFinder&) = delete;
+
+    // 第 index 个文件与之前某个文件内容相同时返回那个文件，否则返回 nullptr；结果未出来时等待
+    // 哈希线程读取文件失败时抛出其异常
+    const FileEntry* duplicateOf(size_t index);
+
+    // 全部文件都已查询后等待哈希线程退出
+    void finish();
+
+    // 哈希线程读取的字节数与累计忙碌时间（秒），finish() 之后有效
+    uint64_t getBytesRead() const;
+    double getBusyTime() const;
+
+    // 调用线程在 duplicateOf 中等待的累计时间（秒）
+    double getWaitTime() const;
+
+private:
+    std::string baseDir_;
+    std::vector<FileEntry*> files_;
+    std::vector<uint64_t> hashes_;     // 构造时取已记录的哈希，0 表示需要计算
+    std::vector<size_t> original_;     // 各文件的内容首次出现的下标（不重复时为自身）
+    size_t ready_;                     // 已判定的文件数
+    bool stop_;
+    std::mutex mutex_;
+    std::condition_variable progress_;
+    std::exception_ptr error_;
+    uint64_t bytesRead_;
+    double busyTime_;
+    double waitTime_;
+    std::vector<uint8_t> buffer_;         // 哈希线程的读缓冲区，比较内容时与 compareBuffer_ 一起使用
+    std::vector<uint8_t> compareBuffer_;
+    std::thread thread_;
+
+    void run();
+    uint64_t hashFile(const std::string& path);
+    bool sameContents(const std::string& pathA, const std::string& pathB);
+};
+
+#endif //HUFFZIP_DUPLICATEFINDER_HPP
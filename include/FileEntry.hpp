@@ -8,9 +8,14 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 
 class FileEntry {
 public:
+    // 序列化后路径之后的定长部分大小，以及一个条目的最小序列化大小（空路径）
+    static const size_t FIXED_FIELDS_SIZE = 8 + 8 + 1 + 8 + 8 + 8 + 8;
+    static const size_t MIN_SERIALIZED_SIZE = 2 + FIXED_FIELDS_SIZE;
+
     // 构造函数
     FileEntry();
     FileEntry(const std::string& relativePath, size_t fileSize, bool isDirectory);
@@ -26,18 +31,30 @@ public:
     size_t getFileSize() const;
     bool isDirectory() const;
     size_t getCompressedSize() const;
+    uint64_t getDataOffset() const;
+    uint64_t getOffsetInBlock() const;
+    int64_t getModifiedTime() const;
+    uint64_t getContentHash() const;
 
     // Setter 方法
     void setRelativePath(const std::string& path);
     void setFileSize(size_t size);
     void setCompressedSize(size_t size);
     void setDirectory(bool isDirectory);
+    void setDataOffset(uint64_t offset);
+    void setOffsetInBlock(uint64_t offset);
+    void setModifiedTime(int64_t modifiedTime);
+    void setContentHash(uint64_t hash);
 
 private:
     std::string relativePath_;   // 相对路径
     size_t fileSize_;            // 原始文件大小
-    size_t compressedSize_;      // 压缩后大小
+    size_t compressedSize_;      // 所在数据块的压缩大小
     bool isDirectory_;           // 是否为目录
+    uint64_t dataOffset_;        // 所在数据块在归档中的偏移
+    uint64_t offsetInBlock_;     // 在数据块解压后内容中的偏移（固实块内的多个文件共享一个块）
+    int64_t modifiedTime_;       // 最后修改时间（Unix 纪元起的纳秒数）
+    uint64_t contentHash_;       // 内容哈希，0 表示未计算
 };
 
 #endif // FILE_ENTRY_HPP
\ No newline at end of file
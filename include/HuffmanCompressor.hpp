@@ -5,23 +5,98 @@
 #ifndef HUFFMAN_COMPRESSOR_HPP
 #define HUFFMAN_COMPRESSOR_HPP
 
+#include <iosfwd>
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <map>
 #include <cstdint>
 #include <chrono>
+#include <memory>
+#include <mutex>
 #include "HuffmanTree.hpp"
 #include "BitStream.hpp"
 #include "FileEntry.hpp"
 
+class BlockReader;
+class BlockWriter;
+class DuplicateFinder;
+class VolumeSet;
+
 class HuffmanCompressor {
 public:
+    // 各阶段耗时（秒）；编码/解码阶段不含等待 I/O 的时间
+    struct PhaseTimes {
+        double traversal;         // 目录遍历
+        double hash;              // 计算内容哈希
+        double histogram;         // 频率统计
+        double treeBuild;         // 构建/读取哈夫曼树
+        double codeGeneration;    // 生成编码表并序列化
+        double encode;            // 编码
+        double decode;            // 解码
+        double ioWait;            // 调用线程等待读写线程
+        double write;             // 写线程落盘（与编码并行）
+    };
+
     // 压缩统计信息
     struct CompressionStats {
+        std::string operation;    // 操作名（compress-file / compress-dir / compress-stream / decompress / analyze ...）
+        std::string isa;          // 内核使用的指令集
         size_t originalSize;      // 原始大小
         size_t compressedSize;    // 压缩后大小
         double compressionRatio;  // 压缩率
         double compressionTime;   // 压缩时间（秒）
+        PhaseTimes phases;        // 分阶段耗时
+        uint64_t bytesProcessed;  // 编码/解码的原始字节数
+        uint64_t bytesRead;       // 从磁盘读取的总字节数（含频率统计）
+        uint64_t blocksProcessed; // 经过读流水线的数据块数
+        uint64_t filesProcessed;  // 处理的文件数
+        uint64_t filesReused;     // 增量模式下原样复制的文件数
+        uint64_t bytesCopied;     // 增量模式下原样复制的压缩字节数
+        uint64_t filesDeduplicated;  // 目录压缩中与之前的文件内容相同、直接引用其数据的文件数
+        uint64_t bytesDeduplicated;  // 这些文件的原始字节数（不再编码）
+        uint64_t bytesSampled;    // 单遍模式下用于估计频率的字节数
+        uint64_t tableBytes;      // 单遍模式下各块编码表的总字节数
+        uint64_t tablesReused;    // 单遍模式下沿用上一块编码表的块数
+        uint64_t pairBlocks;      // 单遍模式下使用字节对字母表的块数
+        std::vector<uint64_t> splitOffsets;  // 自适应分块在文件中选定的块边界
+        uint64_t payloadBits;     // 压缩数据的位数（不含文件头和树）
+        double bitsPerSymbol;     // 平均每个原始字节的编码位数
+        std::map<std::string, double> threadBusyTime;  // 各线程忙碌时间（秒）
+        size_t peakRss;           // 进程峰值常驻内存（字节）
+
+        // 以 JSON 对象输出
+        std::string toJson() const;
+    };
+
+    // 统计信息输出格式
+    enum class StatsFormat {
+        TEXT,
+        JSON
+    };
+
+    // 压缩级别预设
+    enum class Level {
+        FAST,     // 单遍读取、抽样估计频率、码长限制在 11 位以内
+        DEFAULT,  // 两遍读取，整个文件（非固实目录）共用一张编码表
+        MAX       // 单遍读取、完整统计，较小的块各自建表以适应局部统计特征，并尝试字节对字母表
+    };
+
+    // 压缩参数，可由 preset 得到后逐项调整
+    struct CompressionOptions {
+        bool singlePass;          // 单文件只读一遍，每块按自身频率建表并编码为 4 路交错位流
+        size_t sampleInterval;    // 单遍模式下只统计约 1/sampleInterval 的字节来估计频率
+        size_t blockSize;         // 单遍块和固实块的原始数据大小上限
+        unsigned maxCodeLength;   // 最长码长，0 表示不限制；不超过 11 位时解码每个字节只查一次表
+        bool solid;               // 目录压缩把小文件拼接进各自带编码表的固实块，否则全部文件共用一张表
+        bool reuseTables;         // 单遍模式下上一块的编码表代价不高于新表时沿用，不再写表
+        bool adaptiveSplit;       // 单遍模式下在统计特征变化处提前结束当前块
+        size_t minBlockSize;      // 自适应分块的最小块大小（最大为 blockSize）
+        bool pairAlphabet;        // 单遍模式下每块另建字节对字母表，编码更短时改用它（每次查表解出 1 或 2 个字节）
+        bool deduplicate;         // 目录压缩中内容相同的文件只编码一次，其余条目引用同一段数据
+
+        // 指定级别的各项取值
+        static CompressionOptions preset(Level level);
     };
 
     // 构造函数
@@ -34,31 +109,242 @@ public:
     // 压缩目录
     void compressDirectory(const std::string& inputDir, const std::string& outputFile);
 
+    // 向已有目录归档追加文件或目录，只重写末尾的目录索引
+    void appendToArchive(const std::string& archiveFile, const std::vector<std::string>& inputPaths);
+
     // 解压
     void decompress(const std::string& inputFile, const std::string& outputDir);
 
+    // 解压单文件归档到 outputFile（不使用归档中记录的文件名），目录归档抛出 std::invalid_argument
+    void decompressFile(const std::string& inputFile, const std::string& outputFile);
+
+    // 自适应哈夫曼流式压缩：不缓冲整块，输入暂停或达到刷新间隔时输出刷新点
+    // input/output 为 "-" 时使用标准输入/输出，统计信息改为输出到标准错误
+    void compressStream(const std::string& input, const std::string& output);
+
+    // 解压流式归档到单个输出，每个刷新点之前的数据立即写出
+    void decompressStream(const std::string& input, const std::string& output);
+
+    // 抽样估计文件或目录的可压缩性，不写任何输出
+    void analyze(const std::string& inputPath);
+
+    // 按命令名执行 compress-file、compress-dir、decompress、compress-stream、decompress-stream、analyze 之一（analyze 忽略 output）
+    // 命令名无效时抛出 std::invalid_argument
+    void execute(const std::string& command, const std::string& input, const std::string& output);
+
     // 获取统计信息
     CompressionStats getCompressionStats() const;
 
+    // 设置统计信息输出格式
+    void setStatsFormat(StatsFormat format);
+
+    // 统计信息改为输出到 out（nullptr 时恢复为标准输出，流式输出到标准输出时为标准错误）
+    void setStatsOutput(std::ostream* out);
+
+    // 设置全部压缩参数，取值超出范围时抛出 std::invalid_argument
+    void setOptions(const CompressionOptions& options);
+    const CompressionOptions& getOptions() const;
+
+    // 固实模式：小文件按扩展名和路径排序后拼接进共享数据块，每块使用独立编码表
+    void setSolidMode(bool solid);
+
+    // 增量模式：与上一次的目录归档比较，未变化文件所在的数据块原样复制（传空字符串关闭）
+    void setIncrementalBase(const std::string& previousArchive);
+
+    // 记录文件内容哈希，增量模式下额外比较哈希
+    void setContentHash(bool enabled);
+
+    // 单遍模式：单文件压缩只读一遍，每个缓冲块按自身频率建表
+    // sampleInterval > 1 时只统计约 1/sampleInterval 的字节来估计频率
+    void setSinglePass(bool enabled, size_t sampleInterval = 1);
+
+    // 解压时关闭每个输出文件前是否 fsync（默认关闭）
+    void setSyncOutput(bool enabled);
+
+    // 目录解压的工作线程数，0 表示按 CPU 核数选择
+    void setThreadCount(size_t threadCount);
+
+    // 流式压缩每输入多少字节至少输出一个刷新点，0 表示只在输入暂停时刷新
+    void setFlushInterval(size_t bytes);
+
+    // compress-file/compress-stream 在文件头中记录的文件名（解压时的输出文件名），空字符串表示取输入文件名
+    void setMemberName(const std::string& name);
+
+    // 分卷输出：compress-file/compress-dir 把归档按 volumeSize 字节切分为 <输出>.001、.002 …（0 表示不分卷）
+    // directories 非空时各卷按卷号轮流放在其中，解压时也在其中查找各卷
+    // volumeSize 非 0 且小于 VolumeSet::MIN_VOLUME_SIZE 时抛出 std::invalid_argument
+    void setVolumes(uint64_t volumeSize, const std::vector<std::string>& directories);
+
 private:
     HuffmanTree huffmanTree_;
     CompressionStats stats_;
+    StatsFormat statsFormat_;
+    std::ostream* statsOutput_;
+    CompressionOptions options_;
+    std::string incrementalBase_;
+    bool contentHash_;
+    bool syncOutput_;
+    size_t threadCount_;
+    size_t flushInterval_;
+    std::string memberName_;
+    uint64_t volumeSize_;
+    std::vector<std::string> volumeDirs_;
+
+    // 增量模式下可原样复制的旧数据块
+    struct ReusedBlock {
+        uint64_t offset;              // 在旧归档中的偏移
+        uint64_t size;                // 压缩大小
+        std::vector<size_t> members;  // 对应的新文件条目下标
+    };
+
+    struct IncrementalPlan {
+        std::vector<uint8_t> sharedTable;  // 旧归档的共享编码表
+        std::vector<ReusedBlock> blocks;
+        std::vector<bool> reused;          // 各文件条目是否随旧数据块复制
+    };
+
+    // 数据块解码器：按最长码长选定查表位数，每个数据块选择一次
+    struct Decoder {
+        unsigned tableBits;
+        bool longCodes;                            // 存在超过 tableBits 的编码
+        std::vector<uint32_t> table;
+        std::vector<const HuffmanNode*> subtrees;  // 长编码在表长之后的剩余子树
+    };
+
+    // 共享编码表的解码器：首次用到时由某个解压线程准备一次
+    struct SharedDecoder {
+        std::once_flag once;
+        std::unique_ptr<Decoder> decoder;
+    };
+
+    // analyze 命令对单个文件的估计
+    struct FileEstimate {
+        std::string path;
+        uint64_t originalSize;
+        uint64_t bytesSampled;
+        double entropy;            // 样本的 0 阶熵（位/字节）
+        uint64_t estimatedSize;    // 按样本码长推算的压缩大小（含编码表）
+        double sampleSeconds;      // 样本统计、建表和编码的耗时，用于推算压缩时间
+        bool incompressible;
+    };
+
+    // 目录解压任务：同一数据块中的全部文件（空文件单独成为一个任务）
+    struct ExtractJob {
+        uint64_t dataOffset;
+        uint64_t compressedSize;
+        std::vector<const FileEntry*> files;
+    };
 
     // 文件头常量
     static const uint32_t MAGIC_NUMBER = 0x46465548;  // "HUFF"
-    static const uint8_t VERSION = 1;
+    static const uint8_t VERSION = 6;
+
+    // 文件头中可回填字段的偏移：魔数（4字节）+ 版本号（1字节）之后依次为原始大小、树大小、数据大小
+    static const std::streamoff HEADER_ORIGINAL_SIZE_OFFSET = 5;
+    static const std::streamoff HEADER_DATA_SIZE_OFFSET = 21;
+
+    // 文件头类型标志
+    static const uint8_t ARCHIVE_FILE = 0;            // 单文件，文件头后为共享编码表
+    static const uint8_t ARCHIVE_DIRECTORY = 1;       // 目录归档
+    static const uint8_t ARCHIVE_BLOCKED_FILE = 2;    // 单遍压缩的单文件，每块自带编码表
+    static const uint8_t ARCHIVE_STREAM = 3;          // 自适应哈夫曼流，以 END 符号结束，大小字段可能为 0（未知）
+
+    // 目录归档常量
+    static const uint32_t INDEX_MAGIC = 0x58444948;   // "HIDX"，位于归档末尾
+    static const uint8_t BLOCK_SHARED_TABLE = 0;      // 数据块使用文件头中的共享编码表
+    static const uint8_t BLOCK_OWN_TABLE = 1;         // 数据块自带编码表
+    static const uint8_t BLOCK_PREVIOUS_TABLE = 2;    // 单遍数据块沿用上一块的编码表
+    static const uint8_t BLOCK_PAIR_TABLE = 3;        // 单遍数据块使用自带的字节对字母表（见 PairAlphabet）
+    static const size_t MAX_TABLE_SIZE = 1 << 16;     // 数据块编码表大小上限，超出视为损坏
+
+    // 块大小常量：单遍块和固实块的原始数据大小
+    static const size_t DEFAULT_BLOCK_SIZE = 4 << 20;  // 4 MiB
+    static const size_t MIN_BLOCK_SIZE = 64 << 10;     // 64 KiB
+    static const size_t MAX_BLOCK_SIZE = 64 << 20;     // 64 MiB，解压时超出视为损坏
+
+    // 单遍模式常量
+    static const size_t SAMPLE_CHUNK_SIZE = 64;        // 采样时连续统计的字节数
+    static const size_t MIN_SPLIT_SIZE = 16 << 10;     // 自适应分块最小块大小的下限
+    static const size_t SPLIT_WINDOWS = 4;             // 最小块内的窗口数，分块边界按窗口对齐
+
+    // 码长限制的取值范围（0 表示不限制）：256 个符号至少需要 8 位，编码内核最多支持 BitStream::MAX_FAST_CODE_LENGTH 位
+    static const unsigned MIN_CODE_LENGTH_LIMIT = 8;
+    static const unsigned MAX_CODE_LENGTH_LIMIT = BitStream::MAX_FAST_CODE_LENGTH;
+
+    // 流式模式常量
+    static const size_t STREAM_CHUNK_SIZE = 64 << 10;  // 每次从输入读取的最大字节数
+
+    // analyze 常量：每个文件最多抽样 ANALYZE_SAMPLE_COUNT 段，每段 ANALYZE_SAMPLE_SIZE 字节
+    static const size_t ANALYZE_SAMPLE_SIZE = 64 << 10;
+    static const size_t ANALYZE_SAMPLE_COUNT = 16;
+    static constexpr double INCOMPRESSIBLE_RATIO = 0.95;  // 估计大小达到原始大小的该比例视为不可压缩
+
+    // 目录解压常量
+    static const size_t MAX_EXTRACT_THREADS = 8;
+    static const size_t IN_MEMORY_BLOCK_LIMIT = 16 << 20;  // 不超过此大小的数据块整块读入内存解码
 
     // 内部方法
     std::unordered_map<char, size_t> calculateFrequency(const std::string& filePath);
-    void writeHeader(std::ofstream& outFile, const std::string& inputPath,
-                     size_t originalSize, size_t treeSize, size_t dataSize,
-                     bool isDirectory);
-    void readHeader(std::ifstream& inFile, std::string& originalPath,
-                    size_t& originalSize, size_t& treeSize, size_t& dataSize,
-                    bool& isDirectory);
+    std::unordered_map<char, size_t> calculateFrequency(const std::vector<uint8_t>& data);
+    std::unordered_map<char, size_t> calculateFrequency(const uint8_t* data, size_t size);
+    std::unordered_map<char, size_t> estimateFrequency(const uint8_t* data, size_t size);
+    void encodeFile(const std::string& filePath, BitStream& bitStream);
+    void encodeFileSinglePass(const std::string& filePath, BlockWriter& writer, BitStream& bitStream);
+    void encodeBuffer(const uint8_t* data, size_t size, BitStream& bitStream);
+    std::vector<size_t> findSplitPoints(const uint8_t* data, size_t size);
+    Decoder prepareDecoder(const HuffmanTree& tree) const;
+    void decodeFile(const Decoder& decoder, BitStream& bitStream, size_t count,
+                    const std::string& outputPath);
+    void decodeInto(const Decoder& decoder, BitStream& bitStream, size_t count, BlockWriter& writer);
+    void decodeBlockedFile(BitStream& bitStream, uint64_t originalSize, const std::string& outputPath);
+    void writeHeader(BlockWriter& outFile, const std::string& inputPath,
+                     uint64_t originalSize, uint64_t treeSize, uint64_t dataSize,
+                     uint8_t archiveType);
+    template <typename Source>
+    void readHeader(Source& source, std::string& originalPath,
+                    uint64_t& originalSize, uint64_t& treeSize, uint64_t& dataSize,
+                    uint8_t& archiveType);
+    uint64_t decodeAdaptive(BitStream& bitStream, BlockWriter& writer, bool flushOutput);
+    void decompressArchive(const std::string& inputFile, const std::string& outputDir,
+                           const std::string& outputFile);
+    void patchHeader(const std::string& archiveFile, uint64_t originalSize, uint64_t dataSize);
+    std::unique_ptr<BlockWriter> openArchiveWriter(const std::string& outputFile);
+    std::string firstVolumeOf(const std::string& outputFile) const;
     std::vector<FileEntry> traverseDirectory(const std::string& dirPath);
+    void writeSharedTableBlocks(const std::string& inputDir, std::vector<FileEntry>& fileEntries,
+                                BlockWriter& writer, BitStream& bitStream);
+    void writeSolidBlocks(const std::string& inputDir, std::vector<FileEntry>& fileEntries,
+                          BlockWriter& writer, BitStream& bitStream);
+    void writeBlockTable(BlockWriter& writer, const std::vector<uint8_t>& treeData);
+    void resolveDuplicates(DuplicateFinder& finder,
+                           const std::vector<std::pair<FileEntry*, const FileEntry*>>& duplicates);
+    const HuffmanTree* readBlockTable(BitStream& bitStream, HuffmanTree& blockTree);
+    void readOwnTable(BitStream& bitStream, HuffmanTree& blockTree);
+    void computeContentHashes(const std::string& baseDir, std::vector<FileEntry>& fileEntries);
+    IncrementalPlan planIncremental(std::vector<FileEntry>& fileEntries);
+    void copyReusedBlocks(const IncrementalPlan& plan, std::vector<FileEntry>& fileEntries,
+                          BlockWriter& writer);
+    void writeIndex(BlockWriter& writer, const std::vector<FileEntry>& fileEntries);
+    std::vector<FileEntry> readIndex(std::istream& inFile, uint64_t& indexOffset);
+    void extractDirectory(const std::string& inputFile, const VolumeSet* volumes,
+                          const std::vector<FileEntry>& fileEntries, const std::string& outputDir);
+    void createSkeleton(const std::vector<FileEntry>& fileEntries, const std::string& outputDir);
+    void extractBlock(const ExtractJob& job, const std::string& inputFile, const VolumeSet* volumes,
+                      std::istream& archive, std::vector<uint8_t>& buffer, SharedDecoder& sharedDecoder,
+                      const std::string& outputDir, std::mutex& statsMutex);
+    void restoreTimestamps(const std::vector<FileEntry>& fileEntries, const std::string& outputDir);
+    void estimateFile(const std::string& filePath, FileEstimate& estimate, std::vector<uint8_t>& sample,
+                      std::vector<std::vector<uint8_t>>& streamBuffers) const;
+    void printEstimates(const std::vector<FileEstimate>& estimates, double secondsPerByte,
+                        std::ostream& defaultOut) const;
     void createDirectory(const std::string& dirPath);
-    std::string getRelativePath(const std::string& basePath, const std::string& fullPath);
+
+    // 统计辅助方法
+    void resetStats(const std::string& operation);
+    void recordReader(const BlockReader& reader);
+    void recordWriter(const BlockWriter& writer);
+    void finalizeStats(double totalTime);
+    void printStats(std::ostream& out) const;
 };
 
 #endif // HUFFMAN_COMPRESSOR_HPP
\ No newline at end of file
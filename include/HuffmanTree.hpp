@@ -25,6 +25,10 @@ public:
 
     void buildTree(const std::unordered_map<char, size_t>& frequencyMap);
 
+    // 限制最长码长：超出时把频率减半后重建，直到所有编码不超过 maxCodeLength 位（0 表示不限制）
+    // 256 个符号时频率全部相同的树深为 8，因此 maxCodeLength 至少为 8
+    void buildTree(const std::unordered_map<char, size_t>& frequencyMap, unsigned maxCodeLength);
+
     void generateCodes();
 
     std::vector<uint8_t> serialize() const;
@@ -35,6 +39,19 @@ public:
 
     std::string encode(char character) const;
 
+    // 扁平编码表（generateCodes 后有效）：下标为字节值，编码右对齐存放，码长 0 表示该字节不在树中
+    // 码长超过 64 位时 getCodeBits 的内容无效，使用前应检查 getMaxCodeLength
+    const uint64_t* getCodeBits() const;
+    const uint8_t* getCodeLengths() const;
+
+    // 最长编码的位数（仅有根节点时为 0）
+    unsigned getMaxCodeLength() const;
+
+    // 生成解码查找表：以接下来的 tableBits 位为下标，值为 (码长 << 16) | 字符
+    // 码长超过 tableBits 的前缀码长记为 0，低 16 位为 subtrees 中深度 tableBits 处子树的下标
+    std::vector<uint32_t> buildDecodeTable(unsigned tableBits,
+                                           std::vector<const HuffmanNode*>& subtrees) const;
+
     void clear();
 
     HuffmanNode* getRoot() const;
@@ -42,11 +59,16 @@ public:
 private:
     std::unique_ptr<HuffmanNode> root_;
     std::unordered_map<char, std::string> encodingTable_;
+    uint64_t codeBits_[256];
+    uint8_t codeLengths_[256];
 
     // 辅助方法，借助递归 (生成编码/序列化/反序列化)
     void generateCodesHelper(HuffmanNode* node, std::string code);
     void serializeHelper(HuffmanNode* node, std::vector<uint8_t>& data) const;
     HuffmanNode* deserializeHelper(const std::vector<uint8_t>& data, size_t& offset);
+    unsigned maxDepthHelper(const HuffmanNode* node) const;
+    void decodeTableHelper(const HuffmanNode* node, uint32_t code, unsigned length, unsigned tableBits,
+                           std::vector<uint32_t>& table, std::vector<const HuffmanNode*>& subtrees) const;
 };
 
 #endif //HUFFZIP_HUFFMANTREE_HPP
\ No newline at end of file
@@ -0,0 +1,28 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_JSONESCAPE_HPP
+#define HUFFZIP_JSONESCAPE_HPP
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+// 转义 JSON 字符串中的特殊字符
+inline std::string jsonEscape(const std::string& text) {
+    std::ostringstream out;
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (c < 0x20) {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c)
+                << std::dec << std::setfill(' ');
+        } else {
+            out << c;
+        }
+    }
+    return out.str();
+}
+
+#endif //HUFFZIP_JSONESCAPE_HPP
@@ -0,0 +1,99 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_KERNELS_HPP
+#define HUFFZIP_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+class BitStream;
+class BlockWriter;
+class HuffmanNode;
+
+/*
+ * Kernels功能
+ * 1. 热点循环的函数表，同一份实现按不同指令集分别编译
+ * 2. 由 CpuDispatch 在启动时选定一组，调用方通过函数指针调用
+ */
+struct Kernels {
+    // 多路交错编码的路数：第 i 个字节属于第 i % STREAM_COUNT 路
+    static const size_t STREAM_COUNT = 4;
+
+    // 字节对映射表中表示"不是字节对符号"的值
+    static const uint16_t NO_PAIR = 0xFFFF;
+
+    // 查表解码：table/subtrees 由 HuffmanTree::buildDecodeTable 生成，解出 count 个字节
+    using DecodeKernel = void (*)(const uint32_t* table, const HuffmanNode* const* subtrees,
+                                  BitStream& bitStream, size_t count, BlockWriter& writer);
+
+    // 多路交错解码：从各路位流轮流解出共 count 个字节写入 output
+    using DecodeStreamsKernel = void (*)(const uint32_t* table, const HuffmanNode* const* subtrees,
+                                         const uint8_t* const streams[STREAM_COUNT],
+                                         const size_t streamSizes[STREAM_COUNT],
+                                         size_t count, uint8_t* output);
+
+    // 字节对字母表解码：table 由 PairAlphabet::buildDecodeTable 生成，每次查表解出 1 或 2 个字节
+    // 第 k 路位流解出 output 中第 k 段（见 pairSegmentStart）的 count 个字节中的一段
+    using DecodePairsKernel = void (*)(const uint32_t* table,
+                                       const uint8_t* const streams[STREAM_COUNT],
+                                       const size_t streamSizes[STREAM_COUNT],
+                                       size_t count, uint8_t* output);
+
+    // 统计字节频率，结果累加到 counts
+    void (*histogram)(const uint8_t* data, size_t size, size_t counts[256]);
+
+    // XXH64 主循环：依次处理 stripes 个 32 字节条带
+    void (*hashStripes)(uint64_t accumulators[4], const uint8_t* data, size_t stripes);
+
+    // 按扁平编码表编码，要求所有码长不超过 BitStream::MAX_FAST_CODE_LENGTH 位，返回写入的位数
+    uint64_t (*encode)(const uint64_t* codeBits, const uint8_t* codeLengths,
+                       const uint8_t* data, size_t size, BitStream& bitStream);
+
+    // 多路交错编码：各路使用独立的位缓冲区，结束时各自按字节对齐
+    // streams[k] 至少预留 streamCapacity(size, 最长码长) 字节，streamSizes 返回各路字节数
+    // 要求所有码长不超过 BitStream::MAX_FAST_CODE_LENGTH 位，返回写入的总位数
+    uint64_t (*encodeStreams)(const uint64_t* codeBits, const uint8_t* codeLengths,
+                              const uint8_t* data, size_t size,
+                              uint8_t* const streams[STREAM_COUNT], size_t streamSizes[STREAM_COUNT]);
+
+    // 字节对字母表编码：块均分为 STREAM_COUNT 段，每段独立贪心切分并写入一路位流
+    // pairSymbols 以 first | second << 8 为下标，值为字节对的符号或 NO_PAIR
+    // 所有码长不超过 BitStream::MAX_FAST_CODE_LENGTH 位
+    // streams[k] 至少预留 streamCapacity(size, 最长码长) 字节，返回写入的总位数
+    uint64_t (*encodePairs)(const uint16_t* pairSymbols, const uint64_t* codeBits, const uint8_t* codeLengths,
+                            const uint8_t* data, size_t size,
+                            uint8_t* const streams[STREAM_COUNT], size_t streamSizes[STREAM_COUNT]);
+    DecodePairsKernel decodePairs;
+
+    // 按查表位数和是否存在长编码区分的解码内核
+    DecodeKernel decode8;
+    DecodeKernel decode11;
+    DecodeKernel decode12;
+    DecodeKernel decode12Long;
+    DecodeStreamsKernel decodeStreams8;
+    DecodeStreamsKernel decodeStreams11;
+    DecodeStreamsKernel decodeStreams12;
+    DecodeStreamsKernel decodeStreams12Long;
+};
+
+// 多路交错编码时每一路输出缓冲区需要的字节数（含批量写入的余量）
+inline size_t streamCapacity(size_t size, unsigned maxCodeLength) {
+    size_t symbols = (size + Kernels::STREAM_COUNT - 1) / Kernels::STREAM_COUNT;
+    return symbols * maxCodeLength / 8 + 16;
+}
+
+// 字节对编码时第 k 段在块中的起点（k 取 0 到 STREAM_COUNT，第 STREAM_COUNT 段的起点即块长）
+inline size_t pairSegmentStart(size_t size, size_t k) {
+    size_t segment = (size + Kernels::STREAM_COUNT - 1) / Kernels::STREAM_COUNT;
+    return k * segment < size ? k * segment : size;
+}
+
+// 各指令集版本的内核表（仅在支持的平台上编译对应版本，不支持时返回 nullptr）
+const Kernels* scalarKernels();
+const Kernels* sse42Kernels();
+const Kernels* avx2Kernels();
+const Kernels* avx512Kernels();
+
+#endif //HUFFZIP_KERNELS_HPP
@@ -0,0 +1,61 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_PAIRALPHABET_HPP
+#define HUFFZIP_PAIRALPHABET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * PairAlphabet功能
+ * 1. 单遍块的扩展字母表：256 个单字节符号加上块内最常见的若干字节对，字节对 i 为符号 256 + i
+ * 2. 块均分为 Kernels::STREAM_COUNT 段，每段从头贪心切分：当前字节与下一字节组成的字节对在表中时
+ *    作为一个符号，否则作为单字节符号
+ * 3. 范式哈夫曼编码，码长不超过 MAX_CODE_LENGTH 位，解码时查一次表即得到整个符号（1 或 2 个字节）
+ */
+class PairAlphabet {
+public:
+    static const unsigned MAX_CODE_LENGTH = 12;  // 即解码表位数
+    static const size_t MAX_PAIRS = 1024;
+    static const size_t MIN_PAIR_COUNT = 16;     // 出现次数更少的字节对不值得占用编码表
+
+    PairAlphabet();
+
+    // 按数据选择字节对并建立编码，返回编码后的位数（不含编码表）；没有值得使用的字节对时返回 0
+    uint64_t build(const uint8_t* data, size_t size);
+
+    // 编码表：字节对数（2字节）+ 各字节对（各2字节，依次为第一、第二个字节）
+    //       + 各符号码长（每个 4 位，低 4 位在前，0 表示不出现）
+    std::vector<uint8_t> serialize() const;
+
+    // 解析编码表，格式无效时抛出 std::runtime_error
+    void deserialize(const uint8_t* data, size_t size);
+
+    // 解码查找表：以接下来的 MAX_CODE_LENGTH 位为下标
+    // 值为 (码长 << 24) | (字节数 << 16) | (第二个字节 << 8) | 第一个字节，不对应任何编码的项字节数为 0
+    std::vector<uint32_t> buildDecodeTable() const;
+
+    // 编码内核使用：字节对到符号的映射（下标为 first | second << 8）和各符号的编码
+    const uint16_t* getPairSymbols() const;
+    const uint64_t* getCodeBits() const;
+    const uint8_t* getCodeLengths() const;
+
+    size_t getPairCount() const;
+
+private:
+    std::vector<uint16_t> pairs_;        // first | second << 8
+    std::vector<uint16_t> pairSymbols_;  // 65536 项，不是字节对符号时为 Kernels::NO_PAIR
+    std::vector<uint64_t> codeBits_;
+    std::vector<uint8_t> codeLengths_;
+
+    void setPairs(const std::vector<uint16_t>& pairs);
+    void countSymbols(const uint8_t* data, size_t size, std::vector<size_t>& counts) const;
+    void assignLengths(std::vector<size_t> counts);
+    void assignCodes();
+    uint64_t encodedBits(const std::vector<size_t>& counts) const;
+};
+
+#endif //HUFFZIP_PAIRALPHABET_HPP
@@ -0,0 +1,80 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_TRACER_HPP
+#define HUFFZIP_TRACER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Tracer功能
+ * 1. 记录各线程上读取、统计、建表、编码、解码、校验、写入等阶段的起止时间
+ * 2. 每个线程写入自己的事件缓冲区，记录时不加锁；进程退出时合并输出为 Chrome trace-event JSON
+ *    （可在 Perfetto 或 chrome://tracing 中查看）
+ * 3. 未以 HUFFZIP_TRACE 编译时 HUFFZIP_TRACE_SPAN 等宏展开为空，不留下任何调用
+ */
+class Tracer {
+public:
+    static const size_t MAX_EVENTS_PER_THREAD = 1 << 20;  // 超出后丢弃并计数，防止常驻服务无限增长
+
+    // 开始记录，进程退出时把事件写入 outputPath；未编译进追踪功能时抛出 std::runtime_error
+    static void start(const std::string& outputPath);
+
+    static bool isActive() {
+        return active_.load(std::memory_order_relaxed);
+    }
+
+    // 单调时钟的纳秒数
+    static uint64_t now();
+
+    // 记录当前线程上的一段 [start, end)
+    static void record(const char* name, uint64_t start, uint64_t end);
+
+    // 当前线程在追踪视图中显示的名称（name 须为静态字符串），以第一次设置的为准
+    // 调用线程同时充当工作线程时保留原来的名称
+    static void setThreadName(const char* name);
+
+    // 作用域内的一段：构造时记下起点，析构时记录
+    class Span {
+    public:
+        explicit Span(const char* name)
+            : name_(name)
+            , start_(isActive() ? now() : 0) {
+        }
+
+        ~Span() {
+            if (start_ != 0) {
+                record(name_, start_, now());
+            }
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        const char* name_;
+        uint64_t start_;
+    };
+
+private:
+    static std::atomic<bool> active_;
+
+    // 进程退出时输出全部线程的事件
+    static void writeTrace();
+};
+
+#if defined(HUFFZIP_TRACE)
+#define HUFFZIP_TRACE_CONCAT_(a, b) a##b
+#define HUFFZIP_TRACE_VARIABLE_(line) HUFFZIP_TRACE_CONCAT_(traceSpan_, line)
+#define HUFFZIP_TRACE_SPAN(name) Tracer::Span HUFFZIP_TRACE_VARIABLE_(__LINE__)(name)
+#define HUFFZIP_TRACE_THREAD(name) Tracer::setThreadName(name)
+#else
+#define HUFFZIP_TRACE_SPAN(name) do {} while (0)
+#define HUFFZIP_TRACE_THREAD(name) do {} while (0)
+#endif
+
+#endif //HUFFZIP_TRACER_HPP
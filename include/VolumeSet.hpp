@@ -0,0 +1,88 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#ifndef HUFFZIP_VOLUMESET_HPP
+#define HUFFZIP_VOLUMESET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+/*
+ * VolumeSet功能
+ * 1. 分卷归档：逻辑上连续的归档字节依次写入 <归档名>.001、.002 …，每卷不超过卷大小
+ * 2. 各卷可放在不同目录（如不同磁盘），按卷号轮流分配；读取时依次在归档所在目录和给定目录中查找
+ * 3. 读取时按各卷的实际大小把归档偏移映射到卷内偏移，用 pread 读取，多个线程可同时读取
+ */
+class VolumeSet {
+public:
+    static const size_t MAX_VOLUMES = 999;            // 卷号为 3 位数字
+    static const uint64_t MIN_VOLUME_SIZE = 64 << 10;
+
+    // 第 index 个卷（从 1 开始）的路径；directories 非空时按卷号轮流放在其中，文件名不变
+    static std::string volumePath(const std::string& archivePath, const std::vector<std::string>& directories,
+                                  size_t index);
+
+    // archivePath 本身不存在、但能找到第一个卷时为分卷归档；archivePath 也可以直接是第一个卷（.001）
+    static bool isMultiVolume(const std::string& archivePath, const std::vector<std::string>& directories);
+
+    // 依次打开各卷，直到某个卷号在所有位置都找不到；一个卷也找不到时抛出 std::runtime_error
+    VolumeSet(const std::string& archivePath, const std::vector<std::string>& directories);
+    ~VolumeSet();
+
+    VolumeSet(const VolumeSet&) = delete;
+    VolumeSet& operator=(const VolumeSet&) = delete;
+
+    // 全部卷的总大小，即归档的逻辑大小
+    uint64_t size() const;
+    size_t count() const;
+
+    // 从归档偏移 offset 处读取最多 size 个字节，跨卷时接着读下一卷，返回读到的字节数（到达末尾时较少）
+    size_t read(uint64_t offset, void* data, size_t size) const;
+
+    // 在分卷归档上顺序读取、可定位的输入流；每个线程使用自己的 Stream
+    class Stream : public std::istream {
+    public:
+        explicit Stream(const VolumeSet& volumes);
+
+    private:
+        class Buffer : public std::streambuf {
+        public:
+            explicit Buffer(const VolumeSet& volumes);
+
+        protected:
+            int_type underflow() override;
+            std::streamsize xsgetn(char* data, std::streamsize count) override;
+            pos_type seekoff(off_type offset, std::ios_base::seekdir direction,
+                             std::ios_base::openmode mode) override;
+            pos_type seekpos(pos_type position, std::ios_base::openmode mode) override;
+
+        private:
+            const VolumeSet& volumes_;
+            std::vector<char> buffer_;
+            uint64_t bufferOffset_;  // 缓冲区起点的归档偏移
+        };
+
+        Buffer buffer_;
+    };
+
+private:
+    static const size_t READ_BUFFER_SIZE = 64 << 10;  // Stream 的缓冲区大小
+
+    std::vector<std::string> paths_;
+    std::vector<int> fds_;
+    std::vector<uint64_t> starts_;  // 各卷起点的归档偏移，末尾另有一项为总大小
+
+    // 归档路径：去掉直接给出的第一个卷的 .001 后缀
+    static std::string archivePathOf(const std::string& path);
+
+    // 按顺序查找第 index 个卷，找不到时返回空串
+    static std::string findVolume(const std::string& archivePath, const std::vector<std::string>& directories,
+                                  size_t index);
+};
+
+#endif //HUFFZIP_VOLUMESET_HPP
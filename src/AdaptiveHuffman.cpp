@@ -0,0 +1,160 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/AdaptiveHuffman.hpp"
+#include <stdexcept>
+#include <utility>
+
+const unsigned AdaptiveHuffman::SYMBOL_COUNT;
+const unsigned AdaptiveHuffman::FLUSH_SYMBOL;
+const unsigned AdaptiveHuffman::END_SYMBOL;
+const unsigned AdaptiveHuffman::SYMBOL_BITS;
+const int AdaptiveHuffman::MAX_NODES;
+const int AdaptiveHuffman::ROOT;
+const int AdaptiveHuffman::NO_NODE;
+
+AdaptiveHuffman::AdaptiveHuffman() {
+    reset();
+}
+
+// 初始状态：根节点就是 NYT
+void AdaptiveHuffman::reset() {
+    for (auto& node : nodes_) {
+        node = Node{0, NO_NODE, NO_NODE, NO_NODE, -1};
+    }
+    for (auto& leaf : leafOf_) {
+        leaf = NO_NODE;
+    }
+    nyt_ = ROOT;
+    nextFree_ = ROOT - 1;
+}
+
+// 编码一个符号：已出现的符号写出叶子路径，新符号写出 NYT 路径和 9 位原始值
+void AdaptiveHuffman::encode(unsigned symbol, BitStream& bitStream) {
+    if (symbol >= SYMBOL_COUNT) {
+        throw std::invalid_argument("Symbol out of range for adaptive Huffman coder");
+    }
+
+    int leaf = leafOf_[symbol];
+    if (leaf == NO_NODE) {
+        writePath(nyt_, bitStream);
+        bitStream.writeBits(symbol, SYMBOL_BITS);
+        leaf = addSymbol(symbol);
+    } else {
+        writePath(leaf, bitStream);
+    }
+    update(leaf);
+}
+
+// 解码一个符号：从根逐位下行到叶子，到达 NYT 时再读 9 位原始值
+unsigned AdaptiveHuffman::decode(BitStream& bitStream) {
+    int node = ROOT;
+    while (nodes_[node].left != NO_NODE) {
+        node = bitStream.readBit() ? nodes_[node].right : nodes_[node].left;
+    }
+
+    unsigned symbol;
+    if (node == nyt_) {
+        symbol = 0;
+        for (unsigned i = 0; i < SYMBOL_BITS; ++i) {
+            symbol = (symbol << 1) | (bitStream.readBit() ? 1 : 0);
+        }
+        if (symbol >= SYMBOL_COUNT || leafOf_[symbol] != NO_NODE) {
+            throw std::runtime_error("Corrupted adaptive Huffman stream");
+        }
+        node = addSymbol(symbol);
+    } else {
+        symbol = static_cast<unsigned>(nodes_[node].symbol);
+    }
+    update(node);
+    return symbol;
+}
+
+// 从叶子上行收集路径，再按从根到叶的顺序成批写出
+void AdaptiveHuffman::writePath(int node, BitStream& bitStream) const {
+    uint8_t bits[MAX_NODES];
+    int length = 0;
+    while (node != ROOT) {
+        int parent = nodes_[node].parent;
+        bits[length++] = nodes_[parent].right == node ? 1 : 0;
+        node = parent;
+    }
+
+    uint64_t code = 0;
+    unsigned pending = 0;
+    for (int i = length - 1; i >= 0; --i) {
+        code = (code << 1) | bits[i];
+        if (++pending == BitStream::MAX_FAST_CODE_LENGTH) {
+            bitStream.writeBits(code, pending);
+            code = 0;
+            pending = 0;
+        }
+    }
+    if (pending > 0) {
+        bitStream.writeBits(code, pending);
+    }
+}
+
+// 原 NYT 变为内部节点：右子为新符号的叶子，左子为新的 NYT，编号依次递减
+int AdaptiveHuffman::addSymbol(unsigned symbol) {
+    int parent = nyt_;
+    int leaf = nextFree_;
+    int nyt = nextFree_ - 1;
+    nextFree_ -= 2;
+
+    nodes_[leaf] = Node{0, parent, NO_NODE, NO_NODE, static_cast<int>(symbol)};
+    nodes_[nyt] = Node{0, parent, NO_NODE, NO_NODE, -1};
+    nodes_[parent].left = nyt;
+    nodes_[parent].right = leaf;
+    nodes_[parent].symbol = -1;
+
+    leafOf_[symbol] = leaf;
+    nyt_ = nyt;
+    return leaf;
+}
+
+// 权重随编号单调不减，同权重的节点编号相邻，向上扫描即可找到编号最大者
+// 与它交换后再加权，保持兄弟性质（父节点除外：父节点权重相同时说明兄弟是权重为 0 的 NYT）
+void AdaptiveHuffman::update(int node) {
+    while (true) {
+        uint64_t weight = nodes_[node].weight;
+        int leader = node;
+        while (leader < ROOT && nodes_[leader + 1].weight == weight) {
+            leader++;
+        }
+        if (leader != node && leader != nodes_[node].parent) {
+            swapNodes(node, leader);
+            node = leader;
+        }
+
+        nodes_[node].weight++;
+        if (node == ROOT) {
+            return;
+        }
+        node = nodes_[node].parent;
+    }
+}
+
+// 交换节点内容后修正双方子节点的父指针和叶子索引
+void AdaptiveHuffman::swapNodes(int a, int b) {
+    int parentA = nodes_[a].parent;
+    int parentB = nodes_[b].parent;
+    std::swap(nodes_[a], nodes_[b]);
+    nodes_[a].parent = parentA;
+    nodes_[b].parent = parentB;
+
+    for (int index : {a, b}) {
+        Node& node = nodes_[index];
+        if (node.left == NO_NODE) {
+            if (node.symbol >= 0) {
+                leafOf_[node.symbol] = index;
+            } else {
+                nyt_ = index;
+            }
+        } else {
+            nodes_[node.left].parent = index;
+            nodes_[node.right].parent = index;
+        }
+    }
+}
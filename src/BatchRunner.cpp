@@ -0,0 +1,199 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/BatchRunner.hpp"
+#include "../include/JsonEscape.hpp"
+#include "../include/Tracer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+const size_t BatchRunner::MAX_WORKERS;
+
+namespace {
+
+using Clock = std::chrono::high_resolution_clock;
+
+// 按制表符拆分；整行没有制表符时按空白拆分
+std::vector<std::string> splitJobLine(const std::string& line) {
+    std::vector<std::string> fields;
+    if (line.find('\t') != std::string::npos) {
+        std::istringstream in(line);
+        std::string field;
+        while (std::getline(in, field, '\t')) {
+            fields.push_back(field);
+        }
+    } else {
+        std::istringstream in(line);
+        std::string field;
+        while (in >> field) {
+            fields.push_back(field);
+        }
+    }
+    return fields;
+}
+
+}
+
+// 构造函数
+BatchRunner::BatchRunner(const HuffmanCompressor::CompressionOptions& options, size_t workerCount)
+    : options_(options)
+    , workerCount_(workerCount)
+    , statsFormat_(HuffmanCompressor::StatsFormat::TEXT)
+    , syncOutput_(false)
+    , contentHash_(false)
+    , flushInterval_(0) {
+    if (workerCount_ == 0) {
+        workerCount_ = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), MAX_WORKERS);
+    }
+}
+
+void BatchRunner::setStatsFormat(HuffmanCompressor::StatsFormat format) {
+    statsFormat_ = format;
+}
+
+void BatchRunner::setSyncOutput(bool enabled) {
+    syncOutput_ = enabled;
+}
+
+void BatchRunner::setContentHash(bool enabled) {
+    contentHash_ = enabled;
+}
+
+void BatchRunner::setFlushInterval(size_t bytes) {
+    flushInterval_ = bytes;
+}
+
+// 读取任务列表；格式错误的行作为失败的任务保留，在汇总中报告
+std::vector<BatchRunner::Job> BatchRunner::parseJobs(std::istream& jobList) {
+    std::vector<Job> jobs;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(jobList, line)) {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.find_first_not_of(" \t") == std::string::npos || line[line.find_first_not_of(" \t")] == '#') {
+            continue;
+        }
+
+        Job job{lineNumber, "", "", "", false, "", HuffmanCompressor::CompressionStats()};
+        std::vector<std::string> fields = splitJobLine(line);
+        if (fields.size() == 3) {
+            job.command = fields[0];
+            job.input = fields[1];
+            job.output = fields[2];
+        } else {
+            job.command = fields.empty() ? std::string() : fields[0];
+            job.error = "Expected <command> <input> <output>";
+        }
+        jobs.push_back(std::move(job));
+    }
+    return jobs;
+}
+
+// 执行全部任务：各线程按原子计数领取，结果写入各自的槽位
+bool BatchRunner::run(std::istream& jobList, std::ostream& summary) {
+    auto startTime = Clock::now();
+    std::vector<Job> jobs = parseJobs(jobList);
+    std::atomic<size_t> nextJob(0);
+
+    auto worker = [&]() {
+        HUFFZIP_TRACE_THREAD("batch");
+        HuffmanCompressor compressor;
+        compressor.setOptions(options_);
+        compressor.setSyncOutput(syncOutput_);
+        compressor.setContentHash(contentHash_);
+        compressor.setFlushInterval(flushInterval_);
+        compressor.setThreadCount(1);  // 并发来自多个任务，单个任务内不再开线程
+
+        // 各任务的统计信息由汇总统一输出
+        std::ostringstream discarded;
+        compressor.setStatsOutput(&discarded);
+
+        while (true) {
+            size_t index = nextJob++;
+            if (index >= jobs.size()) {
+                break;
+            }
+            Job& job = jobs[index];
+            if (!job.error.empty()) {
+                continue;
+            }
+            try {
+                HUFFZIP_TRACE_SPAN("job");
+                compressor.execute(job.command, job.input, job.output);
+                job.stats = compressor.getCompressionStats();
+                job.succeeded = true;
+            } catch (const std::exception& e) {
+                job.error = e.what();
+            }
+            discarded.str(std::string());
+        }
+    };
+
+    size_t threadCount = std::max<size_t>(1, std::min(workerCount_, jobs.size()));
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threadCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    printSummary(jobs, std::chrono::duration<double>(Clock::now() - startTime).count(), summary);
+    return std::all_of(jobs.begin(), jobs.end(), [](const Job& job) { return job.succeeded; });
+}
+
+// 按任务列表顺序输出每个任务的状态
+void BatchRunner::printSummary(const std::vector<Job>& jobs, double totalTime, std::ostream& summary) const {
+    size_t succeeded = std::count_if(jobs.begin(), jobs.end(), [](const Job& job) { return job.succeeded; });
+    size_t failed = jobs.size() - succeeded;
+
+    if (statsFormat_ == HuffmanCompressor::StatsFormat::JSON) {
+        std::ostringstream out;
+        out << std::setprecision(6) << std::fixed;
+        out << "{\"operation\":\"batch\",\"jobs\":[";
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            const Job& job = jobs[i];
+            out << (i > 0 ? "," : "")
+                << "{\"line\":" << job.line
+                << ",\"command\":\"" << jsonEscape(job.command) << "\""
+                << ",\"input\":\"" << jsonEscape(job.input) << "\""
+                << ",\"output\":\"" << jsonEscape(job.output) << "\"";
+            if (job.succeeded) {
+                out << ",\"status\":\"ok\",\"stats\":" << job.stats.toJson();
+            } else {
+                out << ",\"status\":\"error\",\"error\":\"" << jsonEscape(job.error) << "\"";
+            }
+            out << "}";
+        }
+        out << "]"
+            << ",\"succeeded\":" << succeeded
+            << ",\"failed\":" << failed
+            << ",\"totalTime\":" << totalTime
+            << "}";
+        summary << out.str() << std::endl;
+        return;
+    }
+
+    for (const Job& job : jobs) {
+        if (job.succeeded) {
+            summary << "[ok] " << job.command << " " << job.input << " -> " << job.output
+                    << " (" << job.stats.originalSize << " -> " << job.stats.compressedSize << " bytes, "
+                    << job.stats.compressionTime << " seconds)" << std::endl;
+        } else {
+            summary << "[FAILED] line " << job.line << ": " << job.command << " " << job.input
+                    << " -> " << job.output << ": " << job.error << std::endl;
+        }
+    }
+    summary << "Batch completed: " << succeeded << " succeeded, " << failed << " failed" << std::endl;
+    summary << "Total time: " << totalTime << " seconds" << std::endl;
+}
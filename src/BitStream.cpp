@@ -3,14 +3,25 @@
 //
 
 #include "../include/BitStream.hpp"
+#include "../include/BlockReader.hpp"
+#include "../include/BlockWriter.hpp"
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
+const unsigned BitStream::MAX_FAST_CODE_LENGTH;
+
 // 构造函数
 BitStream::BitStream(const std::string& filePath, Mode mode)
     : mode_(mode)
-    , buffer_(0)
-    , bitPosition_(0)
-    , isOpen_(false) {
+    , isOpen_(false)
+    , bitBuffer_(0)
+    , bitCount_(0)
+    , reader_(nullptr)
+    , writer_(nullptr)
+    , readPtr_(nullptr)
+    , readEnd_(nullptr)
+    , sourceEOF_(false) {
 
     std::ios::openmode openMode = std::ios::binary;
     if (mode == Mode::READ) {
@@ -25,11 +36,42 @@ BitStream::BitStream(const std::string& filePath, Mode mode)
     }
 
     isOpen_ = true;
+}
 
-    // 如果是读模式，读取第一个字节到缓冲区
-    if (mode == Mode::READ) {
-        readBuffer();
-    }
+BitStream::BitStream(BlockReader& reader)
+    : mode_(Mode::READ)
+    , isOpen_(true)
+    , bitBuffer_(0)
+    , bitCount_(0)
+    , reader_(&reader)
+    , writer_(nullptr)
+    , readPtr_(nullptr)
+    , readEnd_(nullptr)
+    , sourceEOF_(false) {
+}
+
+BitStream::BitStream(const uint8_t* data, size_t size)
+    : mode_(Mode::READ)
+    , isOpen_(true)
+    , bitBuffer_(0)
+    , bitCount_(0)
+    , reader_(nullptr)
+    , writer_(nullptr)
+    , readPtr_(data)
+    , readEnd_(data + size)
+    , sourceEOF_(true) {
+}
+
+BitStream::BitStream(BlockWriter& writer)
+    : mode_(Mode::WRITE)
+    , isOpen_(true)
+    , bitBuffer_(0)
+    , bitCount_(0)
+    , reader_(nullptr)
+    , writer_(&writer)
+    , readPtr_(nullptr)
+    , readEnd_(nullptr)
+    , sourceEOF_(false) {
 }
 
 // 析构函数
@@ -48,17 +90,7 @@ void BitStream::writeBit(bool bit) {
         throw std::runtime_error("BitStream not in write mode");
     }
 
-    // 将位写入缓冲区（从高位到低位）
-    if (bit) {
-        buffer_ |= (1 << (7 - bitPosition_));
-    }
-
-    bitPosition_++;
-
-    // 缓冲区满时写入文件
-    if (bitPosition_ == 8) {
-        writeBuffer();
-    }
+    writeBits(bit ? 1 : 0, 1);
 }
 
 // 读取单个位
@@ -67,19 +99,16 @@ bool BitStream::readBit() {
         throw std::runtime_error("BitStream not in read mode");
     }
 
-    if (isEOF()) {
-        throw std::runtime_error("Unexpected end of file");
-    }
-
-    // 从缓冲区读取位（从高位到低位）
-    bool bit = (buffer_ & (1 << (7 - bitPosition_))) != 0;
-    bitPosition_++;
-
-    // 缓冲区空时读取下一个字节
-    if (bitPosition_ == 8) {
-        readBuffer();
+    if (bitCount_ == 0) {
+        refill();
+        if (bitCount_ == 0) {
+            throw std::runtime_error("Unexpected end of file");
+        }
     }
 
+    // 从缓冲区最高位读取
+    bool bit = (bitBuffer_ >> 63) != 0;
+    consumeBits(1);
     return bit;
 }
 
@@ -89,10 +118,7 @@ void BitStream::writeByte(uint8_t byte) {
         throw std::runtime_error("BitStream not in write mode");
     }
 
-    // 写入完整的字节
-    for (int i = 7; i >= 0; --i) {
-        writeBit((byte & (1 << i)) != 0);
-    }
+    writeBits(byte, 8);
 }
 
 // 读取字节
@@ -101,27 +127,84 @@ uint8_t BitStream::readByte() {
         throw std::runtime_error("BitStream not in read mode");
     }
 
-    uint8_t byte = 0;
-    for (int i = 7; i >= 0; --i) {
-        if (readBit()) {
-            byte |= (1 << i);
+    if (bitCount_ < 8) {
+        refill();
+        if (bitCount_ < 8) {
+            throw std::runtime_error("Unexpected end of file");
         }
     }
+
+    uint8_t byte = static_cast<uint8_t>(bitBuffer_ >> 56);
+    consumeBits(8);
     return byte;
 }
 
+// 批量读取字节：先取出缓冲区中的整字节，其余直接从数据块或文件复制
+void BitStream::readBytes(uint8_t* data, size_t size) {
+    if (mode_ != Mode::READ) {
+        throw std::runtime_error("BitStream not in read mode");
+    }
+
+    while (size > 0 && bitCount_ >= 8) {
+        *data++ = static_cast<uint8_t>(bitBuffer_ >> 56);
+        consumeBits(8);
+        size--;
+    }
+
+    while (size > 0) {
+        if (readPtr_ != readEnd_) {
+            size_t chunk = std::min(size, static_cast<size_t>(readEnd_ - readPtr_));
+            std::memcpy(data, readPtr_, chunk);
+            readPtr_ += chunk;
+            data += chunk;
+            size -= chunk;
+        } else if (reader_ && !sourceEOF_) {
+            size_t blockSize = 0;
+            if (!reader_->next(readPtr_, blockSize)) {
+                readPtr_ = readEnd_ = nullptr;
+                sourceEOF_ = true;
+            } else {
+                readEnd_ = readPtr_ + blockSize;
+            }
+        } else if (!reader_ && !sourceEOF_) {
+            fileStream_.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size));
+            size_t got = static_cast<size_t>(fileStream_.gcount());
+            data += got;
+            size -= got;
+            if (size > 0) {
+                sourceEOF_ = true;
+            }
+        } else {
+            throw std::runtime_error("Unexpected end of file");
+        }
+    }
+}
+
 // 刷新缓冲区
 void BitStream::flush() {
-    if (mode_ != Mode::WRITE || bitPosition_ == 0) {
+    if (mode_ != Mode::WRITE) {
         return;
     }
 
-    writeBuffer();
+    // 不足一字节的部分以 0 补齐
+    drainBytes();
+    if (bitCount_ > 0) {
+        bitCount_ = 8;
+        drainBytes();
+    }
+}
+
+// 对齐到下一个字节
+void BitStream::alignToByte() {
+    // 缓冲区按整字节装入，不足一字节的部分就是当前字节的剩余位
+    if (mode_ == Mode::READ) {
+        consumeBits(bitCount_ % 8);
+    }
 }
 
 // 获取未写入的位数
 size_t BitStream::getPendingBits() const {
-    return mode_ == Mode::WRITE ? bitPosition_ : 0;
+    return mode_ == Mode::WRITE ? bitCount_ : 0;
 }
 
 // 关闭文件
@@ -130,29 +213,60 @@ void BitStream::close() {
         if (mode_ == Mode::WRITE) {
             flush();
         }
-        fileStream_.close();
+        if (fileStream_.is_open()) {
+            fileStream_.close();
+        }
         isOpen_ = false;
     }
 }
 
 // 检查是否到达文件末尾
 bool BitStream::isEOF() const {
-    return mode_ == Mode::READ && fileStream_.eof() && bitPosition_ >= 8;
+    return mode_ == Mode::READ && bitCount_ == 0 && sourceEOF_ && readPtr_ == readEnd_;
 }
 
-// 辅助方法：写入缓冲区
-void BitStream::writeBuffer() {
-    fileStream_.write(reinterpret_cast<const char*>(&buffer_), 1);
-    buffer_ = 0;
-    bitPosition_ = 0;
+// 辅助方法：把缓冲区中的整字节写入文件
+void BitStream::drainToFile() {
+    while (bitCount_ >= 8) {
+        fileStream_.put(static_cast<char>(bitBuffer_ >> 56));
+        bitBuffer_ <<= 8;
+        bitCount_ -= 8;
+    }
 }
 
-// 辅助方法：读取缓冲区
-void BitStream::readBuffer() {
-    if (fileStream_.eof()) {
-        return;
-    }
+// 辅助方法：逐字节装入位缓冲区（跨数据块边界或直接读文件时）
+void BitStream::refillSlow() {
+    while (bitCount_ <= 56) {
+        uint8_t byte;
+        if (readPtr_ != readEnd_) {
+            byte = *readPtr_++;
+        } else if (sourceEOF_) {
+            return;
+        } else if (reader_) {
+            // 流式输入只在缓冲区不足一字节时等待新数据，已到达的位先交给调用方
+            if (bitCount_ >= 8 && reader_->isStreaming()) {
+                return;
+            }
 
-    fileStream_.read(reinterpret_cast<char*>(&buffer_), 1);
-    bitPosition_ = 0;
+            // 当前块用完时从读线程取下一块
+            size_t size = 0;
+            if (!reader_->next(readPtr_, size)) {
+                readPtr_ = readEnd_ = nullptr;
+                sourceEOF_ = true;
+                return;
+            }
+            readEnd_ = readPtr_ + size;
+            continue;
+        } else {
+            char c;
+            if (!fileStream_.get(c)) {
+                sourceEOF_ = true;
+                return;
+            }
+            byte = static_cast<uint8_t>(c);
+        }
+
+        bitBuffer_ |= static_cast<uint64_t>(byte) << (56 - bitCount_);
+        bitCount_ += 8;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,279 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/BlockReader.hpp"
+#include "../include/Tracer.hpp"
+#include "../include/VolumeSet.hpp"
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+const size_t BlockReader::DEFAULT_BLOCK_SIZE;
+const size_t BlockReader::DEFAULT_RING_SIZE;
+
+// 构造函数
+BlockReader::BlockReader(const std::string& filePath, uint64_t offset,
+                         size_t blockSize, size_t ringSize)
+    : fd_(-1)
+    , volumes_(nullptr)
+    , volumeOffset_(0)
+    , streaming_(ringSize == 0)
+    , ring_(ringSize == 0 ? 1 : (ringSize < 2 ? 2 : ringSize))
+    , blockSize_(blockSize == 0 ? DEFAULT_BLOCK_SIZE : blockSize)
+    , fillIndex_(0)
+    , consumeIndex_(0)
+    , filled_(0)
+    , holding_(false)
+    , eof_(false)
+    , stop_(false)
+    , bytesRead_(0)
+    , blocksRead_(0)
+    , waitTime_(0.0)
+    , busyTime_(0.0) {
+
+    for (auto& slot : ring_) {
+        slot.data.resize(blockSize_);
+        slot.size = 0;
+    }
+
+    // 流式读取直接使用系统调用，read() 返回已到达的数据而不等待填满整块
+    if (streaming_) {
+        fd_ = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open file: " + filePath);
+        }
+        if (offset > 0 && lseek(fd_, static_cast<off_t>(offset), SEEK_SET) < 0) {
+            ::close(fd_);
+            throw std::runtime_error("Failed to seek in file: " + filePath);
+        }
+        return;
+    }
+
+    fileStream_.open(filePath, std::ios::binary | std::ios::in);
+    if (!fileStream_.is_open()) {
+        throw std::runtime_error("Failed to open file: " + filePath);
+    }
+
+    if (offset > 0) {
+        fileStream_.seekg(static_cast<std::streamoff>(offset));
+        if (!fileStream_) {
+            throw std::runtime_error("Failed to seek in file: " + filePath);
+        }
+    }
+
+    thread_ = std::thread(&BlockReader::run, this);
+}
+
+// 构造函数：从分卷归档读取
+BlockReader::BlockReader(const VolumeSet& volumes, uint64_t offset, size_t blockSize, size_t ringSize)
+    : fd_(-1)
+    , volumes_(&volumes)
+    , volumeOffset_(offset)
+    , streaming_(false)
+    , ring_(ringSize < 2 ? 2 : ringSize)
+    , blockSize_(blockSize == 0 ? DEFAULT_BLOCK_SIZE : blockSize)
+    , fillIndex_(0)
+    , consumeIndex_(0)
+    , filled_(0)
+    , holding_(false)
+    , eof_(false)
+    , stop_(false)
+    , bytesRead_(0)
+    , blocksRead_(0)
+    , waitTime_(0.0)
+    , busyTime_(0.0) {
+
+    for (auto& slot : ring_) {
+        slot.data.resize(blockSize_);
+        slot.size = 0;
+    }
+    thread_ = std::thread(&BlockReader::run, this);
+}
+
+// 析构函数
+BlockReader::~BlockReader() {
+    close();
+}
+
+// 获取下一个数据块
+bool BlockReader::next(const uint8_t*& data, size_t& size) {
+    if (streaming_) {
+        return nextStreaming(data, size);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // 归还上一次取走的槽
+    if (holding_) {
+        consumeIndex_ = (consumeIndex_ + 1) % ring_.size();
+        holding_ = false;
+        notFull_.notify_one();
+    }
+
+    auto ready = [this] { return filled_ > 0 || eof_ || error_; };
+    if (!ready()) {
+        auto waitStart = std::chrono::high_resolution_clock::now();
+        notEmpty_.wait(lock, ready);
+        waitTime_ += std::chrono::duration<double>(
+            std::chrono::high_resolution_clock::now() - waitStart).count();
+    }
+
+    if (filled_ == 0) {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        return false;
+    }
+
+    const Slot& slot = ring_[consumeIndex_];
+    data = slot.data.data();
+    size = slot.size;
+    filled_--;
+    holding_ = true;
+    return true;
+}
+
+// 停止读线程并关闭文件
+void BlockReader::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    notFull_.notify_all();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    if (fileStream_.is_open()) {
+        fileStream_.close();
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool BlockReader::isStreaming() const {
+    return streaming_;
+}
+
+uint64_t BlockReader::getBytesRead() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytesRead_;
+}
+
+uint64_t BlockReader::getBlocksRead() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return blocksRead_;
+}
+
+double BlockReader::getWaitTime() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waitTime_;
+}
+
+double BlockReader::getBusyTime() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return busyTime_;
+}
+
+// 流式读取：阻塞到至少有一个字节或输入结束
+bool BlockReader::nextStreaming(const uint8_t*& data, size_t& size) {
+    if (eof_) {
+        return false;
+    }
+
+    Slot& slot = ring_[0];
+    auto waitStart = std::chrono::high_resolution_clock::now();
+    ssize_t count;
+    do {
+        count = read(fd_, slot.data.data(), blockSize_);
+    } while (count < 0 && errno == EINTR);
+    double waitTime = std::chrono::duration<double>(
+        std::chrono::high_resolution_clock::now() - waitStart).count();
+    if (count < 0) {
+        throw std::runtime_error("Failed to read input file");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    waitTime_ += waitTime;
+    if (count == 0) {
+        eof_ = true;
+        return false;
+    }
+    slot.size = static_cast<size_t>(count);
+    bytesRead_ += slot.size;
+    blocksRead_++;
+    data = slot.data.data();
+    size = slot.size;
+    return true;
+}
+
+// 读线程主循环
+void BlockReader::run() {
+    HUFFZIP_TRACE_THREAD("reader");
+    try {
+        while (true) {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                notFull_.wait(lock, [this] {
+                    return stop_ || filled_ + (holding_ ? 1 : 0) < ring_.size();
+                });
+                if (stop_) {
+                    return;
+                }
+                index = fillIndex_;
+            }
+
+            // 在锁外读取，该槽此时只属于读线程
+            Slot& slot = ring_[index];
+            auto readStart = std::chrono::high_resolution_clock::now();
+            size_t count;
+            {
+                HUFFZIP_TRACE_SPAN("read");
+                if (volumes_ != nullptr) {
+                    count = volumes_->read(volumeOffset_, slot.data.data(), blockSize_);
+                    volumeOffset_ += count;
+                } else {
+                    fileStream_.read(reinterpret_cast<char*>(slot.data.data()),
+                                     static_cast<std::streamsize>(blockSize_));
+                    count = static_cast<size_t>(fileStream_.gcount());
+                }
+            }
+            double readTime = std::chrono::duration<double>(
+                std::chrono::high_resolution_clock::now() - readStart).count();
+            bool atEnd = count < blockSize_;
+
+            if (atEnd && fileStream_.bad()) {
+                throw std::runtime_error("Failed to read input file");
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                busyTime_ += readTime;
+                if (count > 0) {
+                    slot.size = count;
+                    fillIndex_ = (fillIndex_ + 1) % ring_.size();
+                    filled_++;
+                    bytesRead_ += count;
+                    blocksRead_++;
+                }
+                eof_ = atEnd;
+            }
+            notEmpty_.notify_one();
+
+            if (atEnd) {
+                return;
+            }
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+        notEmpty_.notify_one();
+    }
+}
@@ -0,0 +1,541 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/BlockWriter.hpp"
+#include "../include/Tracer.hpp"
+#include "../include/VolumeSet.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+const size_t BlockWriter::DEFAULT_BLOCK_SIZE;
+const size_t BlockWriter::DEFAULT_RING_SIZE;
+const size_t BlockWriter::MIN_KERNEL_COPY;
+const size_t BlockWriter::MAX_KERNEL_COPY;
+
+// 构造函数：新建或截断文件
+BlockWriter::BlockWriter(const std::string& filePath, size_t blockSize, size_t ringSize)
+    : BlockWriter(filePath, OpenMode::TRUNCATE, 0, blockSize, ringSize) {
+}
+
+// 构造函数：按指定模式打开文件
+BlockWriter::BlockWriter(const std::string& filePath, OpenMode mode, uint64_t offset,
+                         size_t blockSize, size_t ringSize)
+    : fd_(-1)
+    , filePath_(filePath)
+    , mode_(mode)
+    , startOffset_(mode == OpenMode::TRUNCATE ? 0 : offset)
+    , ring_(ringSize == 0 ? 1 : (ringSize < 2 ? 2 : ringSize))
+    , blockSize_(blockSize == 0 ? DEFAULT_BLOCK_SIZE : blockSize)
+    , current_(nullptr)
+    , currentSize_(0)
+    , fillIndex_(0)
+    , drainIndex_(0)
+    , pending_(0)
+    , done_(false)
+    , finished_(false)
+    , synchronous_(ringSize == 0)
+    , sync_(false)
+    , bytesSubmitted_(0)
+    , waitTime_(0.0)
+    , busyTime_(0.0)
+    , volumeSize_(0)
+    , volumeIndex_(0)
+    , volumeWritten_(0) {
+
+    int flags = mode == OpenMode::TRUNCATE ? O_WRONLY | O_CREAT | O_TRUNC : O_WRONLY;
+    fd_ = open(filePath.c_str(), flags | O_CLOEXEC, 0666);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to open output file: " + filePath);
+    }
+
+    if (startOffset_ > 0 && lseek(fd_, static_cast<off_t>(startOffset_), SEEK_SET) < 0) {
+        close(fd_);
+        throw std::runtime_error("Failed to seek in output file: " + filePath);
+    }
+
+    for (auto& slot : ring_) {
+        slot.data.resize(blockSize_);
+        slot.size = 0;
+    }
+    current_ = ring_[fillIndex_].data.data();
+
+    if (!synchronous_) {
+        thread_ = std::thread(&BlockWriter::run, this);
+    }
+}
+
+// 构造函数：分卷写入
+BlockWriter::BlockWriter(const std::string& archivePath, const std::vector<std::string>& volumeDirs,
+                         uint64_t volumeSize, size_t blockSize, size_t ringSize)
+    : fd_(-1)
+    , mode_(OpenMode::TRUNCATE)
+    , startOffset_(0)
+    , ring_(ringSize == 0 ? 1 : (ringSize < 2 ? 2 : ringSize))
+    , blockSize_(blockSize == 0 ? DEFAULT_BLOCK_SIZE : blockSize)
+    , current_(nullptr)
+    , currentSize_(0)
+    , fillIndex_(0)
+    , drainIndex_(0)
+    , pending_(0)
+    , done_(false)
+    , finished_(false)
+    , synchronous_(ringSize == 0)
+    , sync_(false)
+    , bytesSubmitted_(0)
+    , waitTime_(0.0)
+    , busyTime_(0.0)
+    , volumeSize_(volumeSize)
+    , archivePath_(archivePath)
+    , volumeDirs_(volumeDirs)
+    , volumeIndex_(1)
+    , volumeWritten_(0) {
+
+    if (volumeSize_ == 0) {
+        throw std::invalid_argument("Volume size must be positive");
+    }
+    openVolume();
+
+    for (auto& slot : ring_) {
+        slot.data.resize(blockSize_);
+        slot.size = 0;
+    }
+    current_ = ring_[fillIndex_].data.data();
+
+    if (!synchronous_) {
+        thread_ = std::thread(&BlockWriter::run, this);
+    }
+}
+
+// 析构函数
+BlockWriter::~BlockWriter() {
+    try {
+        finish();
+    } catch (...) {
+        // 析构中不抛出异常，需要错误信息时应显式调用 finish()
+    }
+}
+
+// 写入任意长度的数据
+void BlockWriter::write(const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        if (currentSize_ == blockSize_) {
+            submit();
+        }
+        size_t chunk = std::min(size, blockSize_ - currentSize_);
+        std::memcpy(current_ + currentSize_, bytes, chunk);
+        currentSize_ += chunk;
+        bytes += chunk;
+        size -= chunk;
+    }
+}
+
+// 提交当前缓冲块并切换到下一个空闲槽
+void BlockWriter::submit() {
+    if (synchronous_) {
+        ring_[fillIndex_].size = currentSize_;
+        writeSlot(ring_[fillIndex_]);
+        bytesSubmitted_ += currentSize_;
+        currentSize_ = 0;
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+
+    if (currentSize_ > 0) {
+        ring_[fillIndex_].size = currentSize_;
+        fillIndex_ = (fillIndex_ + 1) % ring_.size();
+        pending_++;
+        bytesSubmitted_ += currentSize_;
+        notEmpty_.notify_one();
+    }
+
+    // 调用线程需要一个不在写队列中的槽
+    auto ready = [this] { return pending_ < ring_.size() || error_; };
+    if (!ready()) {
+        auto waitStart = std::chrono::high_resolution_clock::now();
+        notFull_.wait(lock, ready);
+        waitTime_ += std::chrono::duration<double>(
+            std::chrono::high_resolution_clock::now() - waitStart).count();
+    }
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+
+    current_ = ring_[fillIndex_].data.data();
+    currentSize_ = 0;
+}
+
+// 提交当前缓冲块并等待写队列清空
+void BlockWriter::flush() {
+    if (currentSize_ > 0) {
+        submit();
+    }
+    if (synchronous_) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    notFull_.wait(lock, [this] { return pending_ == 0 || error_; });
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+// 从其他文件复制数据：先等缓冲的数据落盘，文件偏移随之到达当前位置
+void BlockWriter::copyFrom(int sourceFd, uint64_t offset, uint64_t size) {
+    // 短数据直接读入当前缓冲块，与其他写入一起交给写线程；分卷输出也经缓冲块，由写线程按卷切分
+    if (size < MIN_KERNEL_COPY || volumeSize_ > 0) {
+        while (size > 0) {
+            if (currentSize_ == blockSize_) {
+                submit();
+            }
+            size_t chunk = static_cast<size_t>(std::min<uint64_t>(size, blockSize_ - currentSize_));
+            ssize_t count = pread(sourceFd, current_ + currentSize_, chunk, static_cast<off_t>(offset));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                throw std::runtime_error("Unexpected end of file while copying into: " + filePath_);
+            }
+            currentSize_ += static_cast<size_t>(count);
+            offset += static_cast<uint64_t>(count);
+            size -= static_cast<uint64_t>(count);
+        }
+        return;
+    }
+
+    flush();
+
+    uint64_t remaining = kernelCopy(sourceFd, offset, size);
+    offset += size - remaining;
+
+    // 回退路径：写队列已清空，调用线程持有的槽可直接用作复制缓冲
+    Slot& slot = ring_[fillIndex_];
+    while (remaining > 0) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(remaining, blockSize_));
+        ssize_t count = pread(sourceFd, slot.data.data(), chunk, static_cast<off_t>(offset));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            throw std::runtime_error("Unexpected end of file while copying into: " + filePath_);
+        }
+        slot.size = static_cast<size_t>(count);
+        writeSlot(slot);
+        offset += static_cast<uint64_t>(count);
+        remaining -= static_cast<uint64_t>(count);
+    }
+    slot.size = 0;
+    bytesSubmitted_ += size;
+}
+
+// 换卷只发生在缓冲的数据都已落盘之后，此时写线程空闲，调用线程可以直接操作卷
+void BlockWriter::keepTogether(uint64_t size) {
+    if (volumeSize_ == 0 || size > volumeSize_) {
+        return;
+    }
+    flush();
+    if (volumeWritten_ > 0 && volumeSize_ - volumeWritten_ < size) {
+        nextVolume();
+    }
+}
+
+// 依次尝试 copy_file_range 和 sendfile；跨文件系统、内核过旧或文件类型不支持时返回剩余字节数交给回退路径
+uint64_t BlockWriter::kernelCopy(int sourceFd, uint64_t offset, uint64_t size) {
+#if defined(__linux__)
+    HUFFZIP_TRACE_SPAN("copy");
+    auto copyStart = std::chrono::high_resolution_clock::now();
+    off_t sourceOffset = static_cast<off_t>(offset);
+    uint64_t remaining = size;
+
+    auto unsupported = [](int error) {
+        return error == EXDEV || error == ENOSYS || error == EINVAL || error == EOPNOTSUPP || error == EBADF;
+    };
+
+    bool useCopyRange = true;
+    while (remaining > 0) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(remaining, MAX_KERNEL_COPY));
+        ssize_t copied = useCopyRange ? copy_file_range(sourceFd, &sourceOffset, fd_, nullptr, chunk, 0)
+                                      : sendfile(fd_, sourceFd, &sourceOffset, chunk);
+        if (copied < 0 && errno == EINTR) {
+            continue;
+        }
+        if (copied < 0 && unsupported(errno) && remaining == size) {
+            if (!useCopyRange) {
+                break;
+            }
+            useCopyRange = false;
+            continue;
+        }
+        if (copied < 0) {
+            throw std::runtime_error("Failed to copy into output file: " + filePath_);
+        }
+        if (copied == 0) {
+            throw std::runtime_error("Unexpected end of file while copying into: " + filePath_);
+        }
+        remaining -= static_cast<uint64_t>(copied);
+    }
+
+    double copyTime = std::chrono::duration<double>(
+        std::chrono::high_resolution_clock::now() - copyStart).count();
+    std::lock_guard<std::mutex> lock(mutex_);
+    busyTime_ += copyTime;
+    return remaining;
+#else
+    (void)sourceFd;
+    (void)offset;
+    return size;
+#endif
+}
+
+// 提交剩余数据并等待写线程完成
+void BlockWriter::finish() {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+
+    if (synchronous_) {
+        try {
+            if (currentSize_ > 0) {
+                submit();
+            }
+        } catch (...) {
+            error_ = std::current_exception();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (currentSize_ > 0 && !error_) {
+            ring_[fillIndex_].size = currentSize_;
+            fillIndex_ = (fillIndex_ + 1) % ring_.size();
+            pending_++;
+            bytesSubmitted_ += currentSize_;
+            currentSize_ = 0;
+        }
+        done_ = true;
+    }
+    notEmpty_.notify_one();
+
+    auto waitStart = std::chrono::high_resolution_clock::now();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    bool failed = false;
+    if (fd_ < 0) {
+        // 打开新卷失败时没有需要关闭的卷，错误已记录在 error_ 中
+        waitTime_ += std::chrono::duration<double>(
+            std::chrono::high_resolution_clock::now() - waitStart).count();
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        throw std::runtime_error("Failed to open output file: " + filePath_);
+    }
+    if (!error_) {
+        // 覆盖写入时丢弃新末尾之后的旧内容
+        if (mode_ == OpenMode::OVERWRITE &&
+            ftruncate(fd_, static_cast<off_t>(startOffset_ + bytesSubmitted_)) != 0) {
+            failed = true;
+        }
+        if (sync_ && fsync(fd_) != 0) {
+            failed = true;
+        }
+    }
+    if (close(fd_) != 0) {
+        failed = true;
+    }
+    fd_ = -1;
+    waitTime_ += std::chrono::duration<double>(
+        std::chrono::high_resolution_clock::now() - waitStart).count();
+
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+    if (failed) {
+        throw std::runtime_error("Failed to close output file: " + filePath_);
+    }
+    if (volumeSize_ > 0) {
+        removeStaleVolumes();
+    }
+}
+
+// 预先分配磁盘空间，减少写入过程中的块分配和碎片
+void BlockWriter::preallocate(uint64_t size) {
+#if defined(__linux__)
+    if (size > 0 && volumeSize_ == 0) {
+        // 失败（如文件系统不支持）时按普通写入继续
+        (void)fallocate(fd_, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(startOffset_),
+                        static_cast<off_t>(size));
+    }
+#else
+    (void)size;
+#endif
+}
+
+void BlockWriter::setSync(bool sync) {
+    sync_ = sync;
+}
+
+// 已交给写入器的字节数（含尚未落盘的部分），即当前逻辑写入位置
+uint64_t BlockWriter::getBytesWritten() const {
+    return bytesSubmitted_ + currentSize_;
+}
+
+uint64_t BlockWriter::getPosition() const {
+    return startOffset_ + getBytesWritten();
+}
+
+double BlockWriter::getWaitTime() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waitTime_;
+}
+
+double BlockWriter::getBusyTime() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return busyTime_;
+}
+
+// 把一个缓冲块完整写入文件（处理部分写入和信号中断）
+void BlockWriter::writeSlot(const Slot& slot) {
+    HUFFZIP_TRACE_SPAN("write");
+    auto writeStart = std::chrono::high_resolution_clock::now();
+    const uint8_t* data = slot.data.data();
+    size_t remaining = slot.size;
+    while (remaining > 0) {
+        // 分卷时每次最多写到当前卷末尾，卷写满后换卷再写余下的部分
+        size_t chunk = remaining;
+        if (volumeSize_ > 0) {
+            if (volumeWritten_ == volumeSize_) {
+                nextVolume();
+            }
+            chunk = static_cast<size_t>(std::min<uint64_t>(chunk, volumeSize_ - volumeWritten_));
+        }
+        ssize_t written = ::write(fd_, data, chunk);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to write output file: " + filePath_);
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+        volumeWritten_ += static_cast<uint64_t>(written);
+    }
+    double writeTime = std::chrono::duration<double>(
+        std::chrono::high_resolution_clock::now() - writeStart).count();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    busyTime_ += writeTime;
+}
+
+// 写线程主循环
+void BlockWriter::run() {
+    HUFFZIP_TRACE_THREAD("writer");
+    try {
+        while (true) {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                notEmpty_.wait(lock, [this] { return pending_ > 0 || done_; });
+                if (pending_ == 0) {
+                    return;
+                }
+                index = drainIndex_;
+            }
+
+            // 在锁外写入，该槽此时只属于写线程
+            writeSlot(ring_[index]);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                drainIndex_ = (drainIndex_ + 1) % ring_.size();
+                pending_--;
+            }
+            notFull_.notify_one();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+        notFull_.notify_one();
+    }
+}
+
+// 打开当前卷号对应的卷
+void BlockWriter::openVolume() {
+    filePath_ = VolumeSet::volumePath(archivePath_, volumeDirs_, volumeIndex_);
+    fd_ = open(filePath_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to open output volume: " + filePath_);
+    }
+    volumeWritten_ = 0;
+}
+
+// 关闭写满的卷并打开下一卷；关闭失败时 fd_ 为 -1，finish() 据此报错
+void BlockWriter::nextVolume() {
+    if (volumeIndex_ == VolumeSet::MAX_VOLUMES) {
+        throw std::runtime_error("Archive needs more than " + std::to_string(VolumeSet::MAX_VOLUMES) +
+                                 " volumes: " + archivePath_);
+    }
+
+    int fd = fd_;
+    fd_ = -1;
+    bool failed = sync_ && fsync(fd) != 0;
+    if (close(fd) != 0) {
+        failed = true;
+    }
+    if (failed) {
+        throw std::runtime_error("Failed to close output volume: " + filePath_);
+    }
+
+    volumeIndex_++;
+    openVolume();
+}
+
+// 读取时先在归档所在目录查找卷，因此各位置上卷号不属于本次输出、或与本次写入的卷不是同一文件的都要删除
+void BlockWriter::removeStaleVolumes() {
+    std::vector<std::string> locations;
+    locations.push_back(std::string());
+    locations.insert(locations.end(), volumeDirs_.begin(), volumeDirs_.end());
+
+    for (size_t index = 1; index <= VolumeSet::MAX_VOLUMES; ++index) {
+        std::string written;
+        if (index <= volumeIndex_) {
+            written = VolumeSet::volumePath(archivePath_, volumeDirs_, index);
+        }
+        bool found = false;
+        for (const auto& location : locations) {
+            std::string path = location.empty()
+                ? VolumeSet::volumePath(archivePath_, std::vector<std::string>(), index)
+                : VolumeSet::volumePath(archivePath_, std::vector<std::string>(1, location), index);
+            std::error_code error;
+            if (!std::filesystem::exists(path, error)) {
+                continue;
+            }
+            found = true;
+            if (!written.empty() && std::filesystem::equivalent(path, written, error)) {
+                continue;
+            }
+            std::filesystem::remove(path, error);
+        }
+        if (index > volumeIndex_ && !found) {
+            break;
+        }
+    }
+}
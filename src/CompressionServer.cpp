@@ -0,0 +1,405 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/CompressionServer.hpp"
+#include "../include/Tracer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HUFFZIP_POSIX_SERVER 1
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+const size_t CompressionServer::MAX_WORKERS;
+const size_t CompressionServer::MAX_REQUEST_LINE;
+const size_t CompressionServer::MAX_PASSED_FDS;
+const int CompressionServer::LISTEN_BACKLOG;
+
+// 构造函数
+CompressionServer::CompressionServer(const HuffmanCompressor::CompressionOptions& options, size_t workerCount)
+    : options_(options)
+    , workerCount_(workerCount)
+    , syncOutput_(false)
+    , contentHash_(false)
+    , flushInterval_(0)
+    , listenFd_(-1)
+    , stopping_(false) {
+    if (workerCount_ == 0) {
+        workerCount_ = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), MAX_WORKERS);
+    }
+}
+
+void CompressionServer::setSyncOutput(bool enabled) {
+    syncOutput_ = enabled;
+}
+
+void CompressionServer::setContentHash(bool enabled) {
+    contentHash_ = enabled;
+}
+
+void CompressionServer::setFlushInterval(size_t bytes) {
+    flushInterval_ = bytes;
+}
+
+#if HUFFZIP_POSIX_SERVER
+
+namespace {
+
+// 写出全部数据，对端关闭时返回 false
+bool sendAll(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, p, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// 创建已删除目录项的暂存文件，只能通过描述符访问
+int createScratchFile() {
+    const char* dir = std::getenv("TMPDIR");
+    std::string pattern = std::string(dir && *dir ? dir : "/tmp") + "/huffzip-serve-XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+    int fd = mkstemp(path.data());
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create scratch file in " + pattern);
+    }
+    unlink(path.data());
+    return fd;
+}
+
+// 通过描述符访问文件的路径，压缩器按路径重新打开，偏移与原描述符无关
+std::string fdPath(int fd) {
+    return "/dev/fd/" + std::to_string(fd);
+}
+
+// 按制表符拆分请求行
+std::vector<std::string> splitFields(const std::string& line) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        size_t end = line.find('\t', start);
+        fields.push_back(line.substr(start, end == std::string::npos ? std::string::npos : end - start));
+        if (end == std::string::npos) {
+            return fields;
+        }
+        start = end + 1;
+    }
+}
+
+}
+
+// 监听并分发连接；工作线程在整个服务期间常驻
+void CompressionServer::serve(const std::string& socketPath) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Socket path too long: " + socketPath);
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    // 客户端提前断开时写出失败即可，不应终止整个服务
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // 上次运行遗留的套接字文件直接替换，其他类型的文件不覆盖
+    struct stat st;
+    if (lstat(socketPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(socketPath.c_str());
+    }
+
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd_ < 0) {
+        throw std::runtime_error("Failed to create socket");
+    }
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenFd_, LISTEN_BACKLOG) != 0) {
+        ::close(listenFd_);
+        listenFd_ = -1;
+        throw std::runtime_error("Failed to listen on socket: " + socketPath);
+    }
+    stopping_ = false;
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount_; ++i) {
+        workers.emplace_back(&CompressionServer::run, this);
+    }
+
+    // shutdown 请求关闭监听套接字的读端，accept 随即返回错误
+    while (true) {
+        int connection = accept(listenFd_, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            ::close(connection);
+            break;
+        }
+        pendingConnections_.push_back(connection);
+        hasWork_.notify_one();
+    }
+
+    stop();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    ::close(listenFd_);
+    listenFd_ = -1;
+    unlink(socketPath.c_str());
+}
+
+// 停止接受新连接，已排队的连接仍会处理
+void CompressionServer::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!stopping_) {
+        stopping_ = true;
+        ::shutdown(listenFd_, SHUT_RDWR);
+    }
+    hasWork_.notify_all();
+}
+
+// 工作线程：压缩器和暂存文件在请求之间复用
+void CompressionServer::run() {
+    HUFFZIP_TRACE_THREAD("serve");
+    Worker worker;
+    worker.compressor.setOptions(options_);
+    worker.compressor.setStatsFormat(HuffmanCompressor::StatsFormat::JSON);
+    worker.compressor.setSyncOutput(syncOutput_);
+    worker.compressor.setContentHash(contentHash_);
+    worker.compressor.setFlushInterval(flushInterval_);
+    worker.compressor.setThreadCount(1);  // 并发来自多个请求，单个请求内不再开线程
+    worker.inlineInput = createScratchFile();
+    worker.inlineOutput = createScratchFile();
+    worker.buffer.resize(1 << 20);
+
+    while (true) {
+        int connection;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            hasWork_.wait(lock, [this] { return !pendingConnections_.empty() || stopping_; });
+            if (pendingConnections_.empty()) {
+                break;
+            }
+            connection = pendingConnections_.front();
+            pendingConnections_.pop_front();
+        }
+        {
+            HUFFZIP_TRACE_SPAN("request");
+            handleConnection(worker, connection);
+        }
+        ::close(connection);
+    }
+
+    ::close(worker.inlineInput);
+    ::close(worker.inlineOutput);
+}
+
+// 处理一个请求：读取请求行和随附的描述符，准备输入输出后调用压缩器
+void CompressionServer::handleConnection(Worker& worker, int connection) {
+    std::vector<int> passedFds;
+    std::string line;
+    std::string pending;  // 请求行之后已经读到的内联数据
+
+    // 逐段接收直到换行，描述符随请求的第一段数据到达
+    bool complete = false;
+    while (!complete && line.size() <= MAX_REQUEST_LINE) {
+        char data[4096];
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_PASSED_FDS)];
+        iovec io{data, sizeof(data)};
+        msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = &io;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        ssize_t received = recvmsg(connection, &message, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0) {
+            break;
+        }
+        for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+                size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                const int* fds = reinterpret_cast<const int*>(CMSG_DATA(header));
+                passedFds.insert(passedFds.end(), fds, fds + count);
+            }
+        }
+        if (received == 0) {
+            break;
+        }
+
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', static_cast<size_t>(received)));
+        size_t lineBytes = newline ? static_cast<size_t>(newline - data) : static_cast<size_t>(received);
+        line.append(data, lineBytes);
+        if (newline) {
+            pending.assign(newline + 1, static_cast<size_t>(data + received - (newline + 1)));
+            complete = true;
+        }
+    }
+
+    std::string response;
+    uint64_t outputSize = 0;
+    bool inlineOutput = false;
+    try {
+        if (!complete) {
+            throw std::runtime_error("Incomplete request line");
+        }
+        std::vector<std::string> fields = splitFields(line);
+        const std::string& command = fields[0];
+        if (command == "shutdown") {
+            stop();
+            sendAll(connection, "OK 0 {}\n", 8);
+            for (int fd : passedFds) {
+                ::close(fd);
+            }
+            return;
+        }
+        if (fields.size() != 3 && fields.size() != 4) {
+            throw std::invalid_argument("Expected <command>\\t<input>\\t<output>[\\t<name>]");
+        }
+
+        // 单文件归档记录的文件名：描述符和内联输入没有可用的文件名，未给出时与命令行的标准输入一样记为 stdin
+        std::string memberName = fields.size() == 4 ? fields[3] : std::string();
+        if (memberName.empty() && fields[1] == "-") {
+            memberName = "stdin";
+        }
+        if (memberName == "." || memberName == ".." || memberName.find('/') != std::string::npos) {
+            throw std::invalid_argument("Invalid member name: " + memberName);
+        }
+        if (passedFds.size() > MAX_PASSED_FDS) {
+            throw std::invalid_argument("Too many file descriptors in request");
+        }
+
+        // "-" 依次对应传来的描述符，没有描述符时使用内联数据
+        size_t nextFd = 0;
+        std::string input = fields[1];
+        if (input == "-") {
+            if (nextFd < passedFds.size()) {
+                input = fdPath(passedFds[nextFd++]);
+            } else {
+                if (ftruncate(worker.inlineInput, 0) != 0 || lseek(worker.inlineInput, 0, SEEK_SET) != 0 ||
+                    !sendAll(worker.inlineInput, pending.data(), pending.size())) {
+                    throw std::runtime_error("Failed to buffer inline input");
+                }
+                while (true) {
+                    ssize_t received = ::read(connection, worker.buffer.data(), worker.buffer.size());
+                    if (received < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (received < 0) {
+                        throw std::runtime_error("Failed to receive inline input");
+                    }
+                    if (received == 0) {
+                        break;
+                    }
+                    if (!sendAll(worker.inlineInput, worker.buffer.data(), static_cast<size_t>(received))) {
+                        throw std::runtime_error("Failed to buffer inline input");
+                    }
+                }
+                input = fdPath(worker.inlineInput);
+            }
+        }
+        std::string output = fields[2];
+        if (output == "-") {
+            if (nextFd < passedFds.size()) {
+                output = fdPath(passedFds[nextFd++]);
+            } else {
+                // 清空上一个请求留下的内容，不写输出的命令（analyze）返回空的内联输出
+                if (ftruncate(worker.inlineOutput, 0) != 0) {
+                    throw std::runtime_error("Failed to reset inline output");
+                }
+                output = fdPath(worker.inlineOutput);
+                inlineOutput = true;
+            }
+        }
+
+        std::ostringstream stats;
+        worker.compressor.setStatsOutput(&stats);
+        worker.compressor.setMemberName(memberName);
+        if (command == "decompress" && fields[2] == "-") {
+            // 描述符或内联输出只能容纳一个文件：解出单文件归档的唯一成员，目录归档报错
+            worker.compressor.decompressFile(input, output);
+        } else {
+            worker.compressor.execute(command, input, output);
+        }
+
+        if (inlineOutput) {
+            struct stat st;
+            if (fstat(worker.inlineOutput, &st) != 0) {
+                throw std::runtime_error("Failed to read inline output");
+            }
+            outputSize = static_cast<uint64_t>(st.st_size);
+        }
+        std::string json = stats.str();
+        while (!json.empty() && json.back() == '\n') {
+            json.pop_back();
+        }
+        response = "OK " + std::to_string(outputSize) + " " + json + "\n";
+    } catch (const std::exception& e) {
+        std::string reason = e.what();
+        std::replace(reason.begin(), reason.end(), '\n', ' ');
+        response = "ERROR " + reason + "\n";
+        inlineOutput = false;
+    }
+    worker.compressor.setStatsOutput(nullptr);
+    worker.compressor.setMemberName(std::string());
+    for (int fd : passedFds) {
+        ::close(fd);
+    }
+
+    if (!sendAll(connection, response.data(), response.size()) || !inlineOutput) {
+        return;
+    }
+    uint64_t offset = 0;
+    while (offset < outputSize) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(worker.buffer.size(), outputSize - offset));
+        ssize_t count = pread(worker.inlineOutput, worker.buffer.data(), chunk, static_cast<off_t>(offset));
+        if (count <= 0 || !sendAll(connection, worker.buffer.data(), static_cast<size_t>(count))) {
+            return;
+        }
+        offset += static_cast<uint64_t>(count);
+    }
+}
+
+#else
+
+void CompressionServer::serve(const std::string&) {
+    throw std::runtime_error("serve requires Unix domain sockets");
+}
+
+void CompressionServer::run() {
+}
+
+void CompressionServer::handleConnection(Worker&, int) {
+}
+
+void CompressionServer::stop() {
+}
+
+#endif
@@ -0,0 +1,149 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/ContentHasher.hpp"
+#include "../include/BlockReader.hpp"
+#include "../include/CpuDispatch.hpp"
+#include "../include/Tracer.hpp"
+#include <cstring>
+
+namespace {
+
+const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+uint64_t rotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// 按小端序读取，保证不同平台上的哈希值一致
+uint64_t readLE64(const uint8_t* p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+uint32_t readLE32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t mixRound(uint64_t accumulator, uint64_t input) {
+    accumulator += input * PRIME64_2;
+    accumulator = rotateLeft(accumulator, 31);
+    return accumulator * PRIME64_1;
+}
+
+uint64_t mergeRound(uint64_t accumulator, uint64_t value) {
+    accumulator ^= mixRound(0, value);
+    return accumulator * PRIME64_1 + PRIME64_4;
+}
+
+}
+
+ContentHasher::ContentHasher(uint64_t seed)
+    : seed_(seed)
+    , accumulators_{seed + PRIME64_1 + PRIME64_2, seed + PRIME64_2, seed, seed - PRIME64_1}
+    , buffer_{}
+    , bufferSize_(0)
+    , totalLength_(0) {
+}
+
+// 追加数据
+void ContentHasher::update(const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    totalLength_ += size;
+
+    // 先补齐上次剩余的尾部
+    if (bufferSize_ > 0) {
+        size_t fill = 32 - bufferSize_;
+        if (size < fill) {
+            std::memcpy(buffer_ + bufferSize_, p, size);
+            bufferSize_ += size;
+            return;
+        }
+        std::memcpy(buffer_ + bufferSize_, p, fill);
+        processStripe(buffer_);
+        p += fill;
+        size -= fill;
+        bufferSize_ = 0;
+    }
+
+    if (size >= 32) {
+        size_t stripes = size / 32;
+        CpuDispatch::getKernels().hashStripes(accumulators_, p, stripes);
+        p += stripes * 32;
+        size -= stripes * 32;
+    }
+
+    std::memcpy(buffer_, p, size);
+    bufferSize_ = size;
+}
+
+// 计算当前哈希值
+uint64_t ContentHasher::digest() const {
+    uint64_t hash;
+    if (totalLength_ >= 32) {
+        hash = rotateLeft(accumulators_[0], 1) + rotateLeft(accumulators_[1], 7) +
+               rotateLeft(accumulators_[2], 12) + rotateLeft(accumulators_[3], 18);
+        for (uint64_t accumulator : accumulators_) {
+            hash = mergeRound(hash, accumulator);
+        }
+    } else {
+        hash = seed_ + PRIME64_5;
+    }
+
+    hash += totalLength_;
+
+    const uint8_t* p = buffer_;
+    size_t remaining = bufferSize_;
+    while (remaining >= 8) {
+        hash ^= mixRound(0, readLE64(p));
+        hash = rotateLeft(hash, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+        remaining -= 8;
+    }
+    if (remaining >= 4) {
+        hash ^= static_cast<uint64_t>(readLE32(p)) * PRIME64_1;
+        hash = rotateLeft(hash, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+        remaining -= 4;
+    }
+    while (remaining > 0) {
+        hash ^= static_cast<uint64_t>(*p) * PRIME64_5;
+        hash = rotateLeft(hash, 11) * PRIME64_1;
+        p++;
+        remaining--;
+    }
+
+    // 最终混合
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// 计算整个文件的哈希
+uint64_t ContentHasher::hashFile(const std::string& filePath) {
+    HUFFZIP_TRACE_SPAN("checksum");
+    ContentHasher hasher;
+    BlockReader reader(filePath);
+    const uint8_t* data;
+    size_t size;
+    while (reader.next(data, size)) {
+        hasher.update(data, size);
+    }
+    return hasher.digest();
+}
+
+void ContentHasher::processStripe(const uint8_t* stripe) {
+    CpuDispatch::getKernels().hashStripes(accumulators_, stripe, 1);
+}
@@ -0,0 +1,117 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/CpuDispatch.hpp"
+#include <stdexcept>
+
+namespace {
+
+bool isaForced = false;
+CpuDispatch::Isa forcedIsa = CpuDispatch::Isa::SCALAR;
+
+// 指令集对应的内核表，当前平台未编译该版本时为 nullptr
+const Kernels* kernelsFor(CpuDispatch::Isa isa) {
+    switch (isa) {
+        case CpuDispatch::Isa::SSE42:
+            return sse42Kernels();
+        case CpuDispatch::Isa::AVX2:
+            return avx2Kernels();
+        case CpuDispatch::Isa::AVX512:
+            return avx512Kernels();
+        default:
+            return scalarKernels();
+    }
+}
+
+}
+
+// 检测当前 CPU 支持的最高指令集
+CpuDispatch::Isa CpuDispatch::detectIsa() {
+    if (isSupported(Isa::AVX512)) {
+        return Isa::AVX512;
+    }
+    if (isSupported(Isa::AVX2)) {
+        return Isa::AVX2;
+    }
+    if (isSupported(Isa::SSE42)) {
+        return Isa::SSE42;
+    }
+    return Isa::SCALAR;
+}
+
+// 当前 CPU 是否支持指定指令集（同时要求内核已为该指令集编译）
+bool CpuDispatch::isSupported(Isa isa) {
+    if (!kernelsFor(isa)) {
+        return false;
+    }
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    switch (isa) {
+        case Isa::SCALAR:
+            return true;
+        case Isa::SSE42:
+            return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+        case Isa::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi") &&
+                   __builtin_cpu_supports("bmi2") && isSupported(Isa::SSE42);
+        case Isa::AVX512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+                   isSupported(Isa::AVX2);
+    }
+    return false;
+#else
+    return isa == Isa::SCALAR;
+#endif
+}
+
+// 当前使用的指令集
+CpuDispatch::Isa CpuDispatch::getActiveIsa() {
+    if (isaForced) {
+        return forcedIsa;
+    }
+    static const Isa detected = detectIsa();
+    return detected;
+}
+
+// 强制使用指定指令集
+void CpuDispatch::forceIsa(const std::string& name) {
+    Isa isa;
+    if (name == "scalar") {
+        isa = Isa::SCALAR;
+    } else if (name == "sse4.2") {
+        isa = Isa::SSE42;
+    } else if (name == "avx2") {
+        isa = Isa::AVX2;
+    } else if (name == "avx512") {
+        isa = Isa::AVX512;
+    } else {
+        throw std::invalid_argument("Unknown instruction set: " + name);
+    }
+
+    if (!isSupported(isa)) {
+        throw std::runtime_error("Instruction set not supported on this CPU: " + name);
+    }
+
+    forcedIsa = isa;
+    isaForced = true;
+}
+
+std::string CpuDispatch::isaName(Isa isa) {
+    switch (isa) {
+        case Isa::SSE42:
+            return "sse4.2";
+        case Isa::AVX2:
+            return "avx2";
+        case Isa::AVX512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+// 当前指令集对应的内核
+const Kernels& CpuDispatch::getKernels() {
+    return *kernelsFor(getActiveIsa());
+}
@@ -0,0 +1,255 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/DirectoryScanner.hpp"
+#include "../include/Tracer.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HUFFZIP_POSIX_SCAN 1
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const size_t DirectoryScanner::MAX_THREADS;
+
+namespace {
+
+#if HUFFZIP_POSIX_SCAN
+// 一个目录项的元数据
+struct EntryInfo {
+    bool isDirectory;
+    bool isSymlink;
+    uint64_t size;
+    int64_t modifiedTime;
+};
+
+// 查询 dirFd 下 name 的元数据，符号链接按目标计算（与 std::filesystem 的 is_directory/file_size 一致）
+bool statEntry(int dirFd, const char* name, EntryInfo& info) {
+#if defined(STATX_BASIC_STATS)
+    struct statx st;
+    if (statx(dirFd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT,
+              STATX_TYPE | STATX_SIZE | STATX_MTIME, &st) != 0) {
+        return false;
+    }
+    info.isSymlink = S_ISLNK(st.stx_mode);
+    if (info.isSymlink &&
+        statx(dirFd, name, AT_NO_AUTOMOUNT, STATX_TYPE | STATX_SIZE | STATX_MTIME, &st) != 0) {
+        return false;
+    }
+    info.isDirectory = S_ISDIR(st.stx_mode);
+    info.size = st.stx_size;
+    info.modifiedTime = static_cast<int64_t>(st.stx_mtime.tv_sec) * 1000000000LL + st.stx_mtime.tv_nsec;
+#else
+    struct stat st;
+    if (fstatat(dirFd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return false;
+    }
+    info.isSymlink = S_ISLNK(st.st_mode);
+    if (info.isSymlink && fstatat(dirFd, name, &st, 0) != 0) {
+        return false;
+    }
+    info.isDirectory = S_ISDIR(st.st_mode);
+    info.size = static_cast<uint64_t>(st.st_size);
+#if defined(__APPLE__)
+    info.modifiedTime = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+    info.modifiedTime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+#endif
+    return true;
+}
+#endif
+
+}
+
+// 构造函数
+DirectoryScanner::DirectoryScanner(size_t threadCount)
+    : threadCount_(threadCount)
+    , rootFd_(-1)
+    , activeDirs_(0) {
+    if (threadCount_ == 0) {
+        threadCount_ = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), MAX_THREADS);
+    }
+}
+
+#if HUFFZIP_POSIX_SCAN
+
+// 扫描目录树
+std::vector<FileEntry> DirectoryScanner::scan(const std::string& rootPath) {
+    rootPath_ = rootPath;
+    rootFd_ = open(rootPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (rootFd_ < 0) {
+        throw std::runtime_error("Failed to open directory: " + rootPath);
+    }
+
+    pendingDirs_.assign(1, std::string());
+    activeDirs_ = 1;
+    error_ = nullptr;
+    results_.assign(threadCount_, std::vector<FileEntry>());
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threadCount_; ++i) {
+        workers.emplace_back(&DirectoryScanner::run, this, i);
+    }
+    run(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    close(rootFd_);
+    rootFd_ = -1;
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+
+    // 合并各线程的结果并按路径排序
+    std::vector<FileEntry> fileEntries;
+    size_t total = 0;
+    for (const auto& part : results_) {
+        total += part.size();
+    }
+    fileEntries.reserve(total);
+    for (auto& part : results_) {
+        std::move(part.begin(), part.end(), std::back_inserter(fileEntries));
+    }
+    results_.clear();
+
+    std::sort(fileEntries.begin(), fileEntries.end(), [](const FileEntry& a, const FileEntry& b) {
+        return a.getRelativePath() < b.getRelativePath();
+    });
+    return fileEntries;
+}
+
+// 工作线程：从共享队列取目录扫描，发现的子目录放回队列
+void DirectoryScanner::run(size_t worker) {
+    HUFFZIP_TRACE_THREAD("scan");
+    std::vector<FileEntry>& entries = results_[worker];
+    std::vector<std::string> subdirs;
+
+    while (true) {
+        std::string relativeDir;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            hasWork_.wait(lock, [this] { return !pendingDirs_.empty() || activeDirs_ == 0 || error_; });
+            if (pendingDirs_.empty() || error_) {
+                return;
+            }
+            relativeDir = std::move(pendingDirs_.front());
+            pendingDirs_.pop_front();
+        }
+
+        subdirs.clear();
+        try {
+            HUFFZIP_TRACE_SPAN("scan");
+            scanDirectory(relativeDir, entries, subdirs);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+            hasWork_.notify_all();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& dir : subdirs) {
+                pendingDirs_.push_back(std::move(dir));
+            }
+            activeDirs_ += subdirs.size();
+            activeDirs_--;
+        }
+        // 队列为空且没有正在扫描的目录时唤醒所有线程退出
+        hasWork_.notify_all();
+    }
+}
+
+// 扫描单个目录：读取全部目录项，子目录交给队列（指向目录的符号链接不展开）
+void DirectoryScanner::scanDirectory(const std::string& relativeDir, std::vector<FileEntry>& entries,
+                                     std::vector<std::string>& subdirs) {
+    int dirFd = relativeDir.empty()
+                    ? dup(rootFd_)
+                    : openat(rootFd_, relativeDir.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (dirFd < 0) {
+        throw std::runtime_error("Failed to open directory: " + rootPath_ + "/" + relativeDir);
+    }
+
+    // fdopendir 接管 dirFd，readdir 每次系统调用批量取回多个目录项
+    DIR* dir = fdopendir(dirFd);
+    if (!dir) {
+        close(dirFd);
+        throw std::runtime_error("Failed to read directory: " + rootPath_ + "/" + relativeDir);
+    }
+
+    std::string prefix = relativeDir.empty() ? std::string() : relativeDir + "/";
+    while (struct dirent* item = readdir(dir)) {
+        const char* name = item->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+
+        EntryInfo info;
+        if (!statEntry(dirFd, name, info)) {
+            closedir(dir);
+            throw std::runtime_error("Failed to stat: " + rootPath_ + "/" + prefix + name);
+        }
+
+        std::string relativePath = prefix + name;
+        entries.emplace_back(relativePath, info.isDirectory ? 0 : static_cast<size_t>(info.size),
+                             info.isDirectory);
+        entries.back().setModifiedTime(info.modifiedTime);
+        if (info.isDirectory && !info.isSymlink) {
+            subdirs.push_back(std::move(relativePath));
+        }
+    }
+
+    closedir(dir);
+}
+
+// 单个路径的修改时间
+int64_t DirectoryScanner::modifiedTime(const std::string& path) {
+    EntryInfo info;
+    if (!statEntry(AT_FDCWD, path.c_str(), info)) {
+        throw std::runtime_error("Failed to stat: " + path);
+    }
+    return info.modifiedTime;
+}
+
+#else
+
+// 非 POSIX 平台：单线程遍历，修改时间使用文件系统时钟计数
+std::vector<FileEntry> DirectoryScanner::scan(const std::string& rootPath) {
+    std::vector<FileEntry> fileEntries;
+    std::filesystem::path root(rootPath);
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(root)) {
+        std::string relativePath = entry.path().lexically_relative(root).generic_string();
+        bool isDirectory = entry.is_directory();
+        fileEntries.emplace_back(relativePath, isDirectory ? 0 : entry.file_size(), isDirectory);
+        fileEntries.back().setModifiedTime(
+            static_cast<int64_t>(entry.last_write_time().time_since_epoch().count()));
+    }
+
+    std::sort(fileEntries.begin(), fileEntries.end(), [](const FileEntry& a, const FileEntry& b) {
+        return a.getRelativePath() < b.getRelativePath();
+    });
+    return fileEntries;
+}
+
+void DirectoryScanner::run(size_t) {
+}
+
+void DirectoryScanner::scanDirectory(const std::string&, std::vector<FileEntry>&, std::vector<std::string>&) {
+}
+
+int64_t DirectoryScanner::modifiedTime(const std::string& path) {
+    return static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+}
+
+#endif
@@ -0,0 +1,204 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/DuplicateFinder.hpp"
+#include "../include/ContentHasher.hpp"
+#include "../include/Tracer.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+
+const size_t DuplicateFinder::READ_CHUNK_SIZE;
+
+namespace {
+
+// 打开的只读文件，离开作用域时关闭
+class InputFile {
+public:
+    explicit InputFile(const std::string& path)
+        : path_(path)
+        , fd_(open(path.c_str(), O_RDONLY | O_CLOEXEC)) {
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+    }
+
+    ~InputFile() {
+        close(fd_);
+    }
+
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+
+    // 读满 buffer 或到达文件末尾，返回读到的字节数
+    size_t read(uint8_t* buffer, size_t size) {
+        size_t total = 0;
+        while (total < size) {
+            ssize_t count = ::read(fd_, buffer + total, size - total);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0) {
+                throw std::runtime_error("Failed to read file: " + path_);
+            }
+            if (count == 0) {
+                break;
+            }
+            total += static_cast<size_t>(count);
+        }
+        return total;
+    }
+
+private:
+    std::string path_;
+    int fd_;
+};
+
+}
+
+// 构造函数
+DuplicateFinder::DuplicateFinder(const std::string& baseDir, const std::vector<FileEntry*>& files)
+    : baseDir_(baseDir)
+    , files_(files)
+    , hashes_(files.size())
+    , original_(files.size())
+    , ready_(0)
+    , stop_(false)
+    , bytesRead_(0)
+    , busyTime_(0.0)
+    , waitTime_(0.0) {
+    for (size_t i = 0; i < files_.size(); ++i) {
+        hashes_[i] = files_[i]->getContentHash();
+    }
+    thread_ = std::thread(&DuplicateFinder::run, this);
+}
+
+// 析构函数
+DuplicateFinder::~DuplicateFinder() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        thread_.join();
+    }
+}
+
+// 等待哈希线程退出
+void DuplicateFinder::finish() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+// 查询第 index 个文件是否重复
+const FileEntry* DuplicateFinder::duplicateOf(size_t index) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto ready = [&] { return ready_ > index || error_; };
+    if (!ready()) {
+        auto waitStart = std::chrono::high_resolution_clock::now();
+        progress_.wait(lock, ready);
+        waitTime_ += std::chrono::duration<double>(
+            std::chrono::high_resolution_clock::now() - waitStart).count();
+    }
+    if (ready_ <= index) {
+        std::rethrow_exception(error_);
+    }
+    return original_[index] == index ? nullptr : files_[original_[index]];
+}
+
+uint64_t DuplicateFinder::getBytesRead() const {
+    return bytesRead_;
+}
+
+double DuplicateFinder::getBusyTime() const {
+    return busyTime_;
+}
+
+double DuplicateFinder::getWaitTime() const {
+    return waitTime_;
+}
+
+// 哈希线程：依次判定每个文件，只有判定结果的发布需要加锁
+void DuplicateFinder::run() {
+    HUFFZIP_TRACE_THREAD("dedup");
+    auto startTime = std::chrono::high_resolution_clock::now();
+    try {
+        buffer_.resize(READ_CHUNK_SIZE);
+        // 哈希到同一哈希值下各个不同内容的首个文件
+        std::unordered_map<uint64_t, std::vector<size_t>> seen;
+        for (size_t i = 0; i < files_.size(); ++i) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stop_) {
+                    break;
+                }
+            }
+
+            std::string path = baseDir_ + "/" + files_[i]->getRelativePath();
+            if (hashes_[i] == 0) {
+                hashes_[i] = hashFile(path);
+            }
+
+            size_t original = i;
+            std::vector<size_t>& candidates = seen[hashes_[i]];
+            for (size_t candidate : candidates) {
+                if (files_[candidate]->getFileSize() == files_[i]->getFileSize() &&
+                    sameContents(baseDir_ + "/" + files_[candidate]->getRelativePath(), path)) {
+                    original = candidate;
+                    break;
+                }
+            }
+            if (original == i) {
+                candidates.push_back(i);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            original_[i] = original;
+            ready_ = i + 1;
+            progress_.notify_one();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+        progress_.notify_one();
+    }
+    busyTime_ = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
+
+// 计算单个文件的哈希
+uint64_t DuplicateFinder::hashFile(const std::string& path) {
+    HUFFZIP_TRACE_SPAN("checksum");
+    ContentHasher hasher;
+    InputFile file(path);
+    size_t count;
+    while ((count = file.read(buffer_.data(), buffer_.size())) > 0) {
+        hasher.update(buffer_.data(), count);
+        bytesRead_ += count;
+    }
+    return hasher.digest();
+}
+
+// 逐块比较两个文件的内容
+bool DuplicateFinder::sameContents(const std::string& pathA, const std::string& pathB) {
+    HUFFZIP_TRACE_SPAN("compare");
+    InputFile fileA(pathA);
+    InputFile fileB(pathB);
+    compareBuffer_.resize(READ_CHUNK_SIZE);
+    while (true) {
+        size_t countA = fileA.read(buffer_.data(), buffer_.size());
+        size_t countB = fileB.read(compareBuffer_.data(), compareBuffer_.size());
+        bytesRead_ += countA + countB;
+        if (countA != countB || std::memcmp(buffer_.data(), compareBuffer_.data(), countA) != 0) {
+            return false;
+        }
+        if (countA == 0) {
+            return true;
+        }
+    }
+}
@@ -2,23 +2,35 @@
 // Created by Musubi on 2026/1/18.
 //
 #include "../include/FileEntry.hpp"
+#include "../include/ByteOrder.hpp"
 #include <stdexcept>
 
+const size_t FileEntry::FIXED_FIELDS_SIZE;
+const size_t FileEntry::MIN_SERIALIZED_SIZE;
+
 // 构造函数
 FileEntry::FileEntry()
     : fileSize_(0)
     , compressedSize_(0)
-    , isDirectory_(false) {
+    , isDirectory_(false)
+    , dataOffset_(0)
+    , offsetInBlock_(0)
+    , modifiedTime_(0)
+    , contentHash_(0) {
 }
 
 FileEntry::FileEntry(const std::string& relativePath, size_t fileSize, bool isDirectory)
     : relativePath_(relativePath)
     , fileSize_(fileSize)
     , compressedSize_(0)
-    , isDirectory_(isDirectory) {
+    , isDirectory_(isDirectory)
+    , dataOffset_(0)
+    , offsetInBlock_(0)
+    , modifiedTime_(0)
+    , contentHash_(0) {
 }
 
-// 序列化
+// 序列化（多字节字段为小端序）
 std::vector<uint8_t> FileEntry::serialize() const {
     std::vector<uint8_t> data;
 
@@ -26,27 +38,32 @@ std::vector<uint8_t> FileEntry::serialize() const {
     if (relativePath_.size() > 65535) {
         throw std::runtime_error("Path too long");
     }
-
-    uint16_t pathLength = static_cast<uint16_t>(relativePath_.size());
-    data.push_back(static_cast<uint8_t>(pathLength >> 8));
-    data.push_back(static_cast<uint8_t>(pathLength & 0xFF));
+    appendLE(data, relativePath_.size(), 2);
 
     // 路径字符串
     data.insert(data.end(), relativePath_.begin(), relativePath_.end());
 
     // 文件大小（8字节）
-    for (int i = 7; i >= 0; --i) {
-        data.push_back(static_cast<uint8_t>((fileSize_ >> (i * 8)) & 0xFF));
-    }
+    appendLE(data, fileSize_, 8);
 
     // 压缩大小（8字节）
-    for (int i = 7; i >= 0; --i) {
-        data.push_back(static_cast<uint8_t>((compressedSize_ >> (i * 8)) & 0xFF));
-    }
+    appendLE(data, compressedSize_, 8);
 
     // 目录标志（1字节）
     data.push_back(isDirectory_ ? 1 : 0);
 
+    // 数据块偏移（8字节）
+    appendLE(data, dataOffset_, 8);
+
+    // 块内偏移（8字节）
+    appendLE(data, offsetInBlock_, 8);
+
+    // 修改时间（8字节）
+    appendLE(data, static_cast<uint64_t>(modifiedTime_), 8);
+
+    // 内容哈希（8字节）
+    appendLE(data, contentHash_, 8);
+
     return data;
 }
 
@@ -57,8 +74,7 @@ void FileEntry::deserialize(const std::vector<uint8_t>& data, size_t& offset) {
     }
 
     // 读取路径长度
-    uint16_t pathLength = (static_cast<uint16_t>(data[offset]) << 8) |
-                          static_cast<uint16_t>(data[offset + 1]);
+    size_t pathLength = static_cast<size_t>(loadLE(data.data() + offset, 2));
     offset += 2;
 
     // 读取路径字符串
@@ -69,32 +85,20 @@ void FileEntry::deserialize(const std::vector<uint8_t>& data, size_t& offset) {
     relativePath_.assign(data.begin() + offset, data.begin() + offset + pathLength);
     offset += pathLength;
 
-    // 读取文件大小（8字节）
-    if (offset + 8 > data.size()) {
-        throw std::runtime_error("Insufficient data for file size");
-    }
-
-    fileSize_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        fileSize_ = (fileSize_ << 8) | data[offset++];
-    }
-
-    // 读取压缩大小（8字节）
-    if (offset + 8 > data.size()) {
-        throw std::runtime_error("Insufficient data for compressed size");
-    }
-
-    compressedSize_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        compressedSize_ = (compressedSize_ << 8) | data[offset++];
-    }
-
-    // 读取目录标志（1字节）
-    if (offset >= data.size()) {
-        throw std::runtime_error("Insufficient data for directory flag");
+    // 定长字段：文件大小、压缩大小、目录标志、数据块偏移、块内偏移、修改时间、内容哈希
+    if (offset + FIXED_FIELDS_SIZE > data.size()) {
+        throw std::runtime_error("Insufficient data for file entry");
     }
 
-    isDirectory_ = (data[offset++] != 0);
+    const uint8_t* fields = data.data() + offset;
+    fileSize_ = static_cast<size_t>(loadLE(fields, 8));
+    compressedSize_ = static_cast<size_t>(loadLE(fields + 8, 8));
+    isDirectory_ = fields[16] != 0;
+    dataOffset_ = loadLE(fields + 17, 8);
+    offsetInBlock_ = loadLE(fields + 25, 8);
+    modifiedTime_ = static_cast<int64_t>(loadLE(fields + 33, 8));
+    contentHash_ = loadLE(fields + 41, 8);
+    offset += FIXED_FIELDS_SIZE;
 }
 
 // Getter 方法
@@ -114,6 +118,22 @@ size_t FileEntry::getCompressedSize() const {
     return compressedSize_;
 }
 
+uint64_t FileEntry::getDataOffset() const {
+    return dataOffset_;
+}
+
+uint64_t FileEntry::getOffsetInBlock() const {
+    return offsetInBlock_;
+}
+
+int64_t FileEntry::getModifiedTime() const {
+    return modifiedTime_;
+}
+
+uint64_t FileEntry::getContentHash() const {
+    return contentHash_;
+}
+
 // Setter 方法
 void FileEntry::setRelativePath(const std::string& path) {
     relativePath_ = path;
@@ -129,4 +149,20 @@ void FileEntry::setCompressedSize(size_t size) {
 
 void FileEntry::setDirectory(bool isDirectory) {
     isDirectory_ = isDirectory;
+}
+
+void FileEntry::setDataOffset(uint64_t offset) {
+    dataOffset_ = offset;
+}
+
+void FileEntry::setOffsetInBlock(uint64_t offset) {
+    offsetInBlock_ = offset;
+}
+
+void FileEntry::setModifiedTime(int64_t modifiedTime) {
+    modifiedTime_ = modifiedTime;
+}
+
+void FileEntry::setContentHash(uint64_t hash) {
+    contentHash_ = hash;
 }
\ No newline at end of file
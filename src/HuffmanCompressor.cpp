@@ -2,23 +2,236 @@
 // Created by Musubi on 2026/1/18.
 //
 #include "../include/HuffmanCompressor.hpp"
+#include "../include/AdaptiveHuffman.hpp"
+#include "../include/BlockReader.hpp"
+#include "../include/BlockWriter.hpp"
+#include "../include/ByteOrder.hpp"
+#include "../include/ContentHasher.hpp"
+#include "../include/CpuDispatch.hpp"
+#include "../include/DirectoryScanner.hpp"
+#include "../include/DuplicateFinder.hpp"
+#include "../include/JsonEscape.hpp"
+#include "../include/PairAlphabet.hpp"
+#include "../include/Tracer.hpp"
+#include "../include/VolumeSet.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
 #include <filesystem>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <set>
 #include <iostream>
+#include <sstream>
+#include <iomanip>
 #include <stdexcept>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <thread>
+#endif
 
 const uint32_t HuffmanCompressor::MAGIC_NUMBER;
 const uint8_t HuffmanCompressor::VERSION;
+const uint32_t HuffmanCompressor::INDEX_MAGIC;
+const uint8_t HuffmanCompressor::BLOCK_SHARED_TABLE;
+const uint8_t HuffmanCompressor::BLOCK_OWN_TABLE;
+const uint8_t HuffmanCompressor::BLOCK_PREVIOUS_TABLE;
+const uint8_t HuffmanCompressor::BLOCK_PAIR_TABLE;
+const size_t HuffmanCompressor::MAX_TABLE_SIZE;
+const std::streamoff HuffmanCompressor::HEADER_ORIGINAL_SIZE_OFFSET;
+const std::streamoff HuffmanCompressor::HEADER_DATA_SIZE_OFFSET;
+const uint8_t HuffmanCompressor::ARCHIVE_FILE;
+const uint8_t HuffmanCompressor::ARCHIVE_DIRECTORY;
+const uint8_t HuffmanCompressor::ARCHIVE_BLOCKED_FILE;
+const uint8_t HuffmanCompressor::ARCHIVE_STREAM;
+const size_t HuffmanCompressor::STREAM_CHUNK_SIZE;
+const size_t HuffmanCompressor::DEFAULT_BLOCK_SIZE;
+const size_t HuffmanCompressor::MIN_BLOCK_SIZE;
+const size_t HuffmanCompressor::MAX_BLOCK_SIZE;
+const unsigned HuffmanCompressor::MIN_CODE_LENGTH_LIMIT;
+const unsigned HuffmanCompressor::MAX_CODE_LENGTH_LIMIT;
+const size_t HuffmanCompressor::SAMPLE_CHUNK_SIZE;
+const size_t HuffmanCompressor::MIN_SPLIT_SIZE;
+const size_t HuffmanCompressor::SPLIT_WINDOWS;
+const size_t HuffmanCompressor::MAX_EXTRACT_THREADS;
+const size_t HuffmanCompressor::ANALYZE_SAMPLE_SIZE;
+const size_t HuffmanCompressor::ANALYZE_SAMPLE_COUNT;
+const size_t HuffmanCompressor::IN_MEMORY_BLOCK_LIMIT;
+
+namespace {
+
+using Clock = std::chrono::high_resolution_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 进程峰值常驻内存（字节），不支持的平台返回 0
+size_t peakResidentSetSize() {
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+// 由计数数组生成频率表
+std::unordered_map<char, size_t> toFrequencyMap(const size_t counts[256]) {
+    std::unordered_map<char, size_t> frequencyMap;
+    for (int i = 0; i < 256; ++i) {
+        if (counts[i] > 0) {
+            frequencyMap[static_cast<char>(i)] = counts[i];
+        }
+    }
+    return frequencyMap;
+}
+
+// 由频率表还原计数数组
+void toCounts(const std::unordered_map<char, size_t>& frequencyMap, size_t counts[256]) {
+    std::fill(counts, counts + 256, 0);
+    for (const auto& pair : frequencyMap) {
+        counts[static_cast<uint8_t>(pair.first)] = pair.second;
+    }
+}
+
+// 按码长编码全部计数所需的位数；出现的字节在表中没有编码时返回 UINT64_MAX
+uint64_t encodedBits(const size_t counts[256], const uint8_t* codeLengths) {
+    uint64_t bits = 0;
+    for (int i = 0; i < 256; ++i) {
+        if (counts[i] > 0) {
+            if (codeLengths[i] == 0) {
+                return UINT64_MAX;
+            }
+            bits += static_cast<uint64_t>(counts[i]) * codeLengths[i];
+        }
+    }
+    return bits;
+}
+
+// 0 阶熵给出的编码位数下界
+double entropyBits(const size_t counts[256]) {
+    uint64_t total = 0;
+    for (int i = 0; i < 256; ++i) {
+        total += counts[i];
+    }
+    double bits = 0.0;
+    for (int i = 0; i < 256; ++i) {
+        if (counts[i] > 0) {
+            bits -= counts[i] * std::log2(static_cast<double>(counts[i]) / total);
+        }
+    }
+    return bits;
+}
+
+// 自带编码表的块头位数：类型、表大小和 symbols 个叶子的序列化树（叶子 2 字节，内部节点 1 字节）
+uint64_t tableBits(size_t symbols) {
+    return (9 + 3 * std::max<size_t>(symbols, 2) - 1) * 8;
+}
+
+// 把文件的 size 个字节追加到缓冲区末尾
+void appendFileContents(const std::string& filePath, size_t size, std::vector<uint8_t>& buffer) {
+    std::ifstream inFile(filePath, std::ios::binary);
+    if (!inFile) {
+        throw std::runtime_error("Failed to open file: " + filePath);
+    }
+
+    size_t oldSize = buffer.size();
+    buffer.resize(oldSize + size);
+    inFile.read(reinterpret_cast<char*>(buffer.data() + oldSize), static_cast<std::streamsize>(size));
+    if (static_cast<size_t>(inFile.gcount()) != size) {
+        throw std::runtime_error("File changed during compression: " + filePath);
+    }
+}
+
+// 文件最后修改时间（Unix 纪元起的纳秒数）
+int64_t modifiedTimeOf(const std::filesystem::path& path) {
+    return DirectoryScanner::modifiedTime(path.string());
+}
+
+// 按小端序写入 value 的低 bytes 个字节
+void writeLE(BlockWriter& writer, uint64_t value, size_t bytes) {
+    uint8_t buffer[8];
+    storeLE(buffer, value, bytes);
+    writer.write(buffer, bytes);
+}
+
+// 从位流按小端序读取 bytes 个字节（位流须已对齐到字节）
+uint64_t readLE(BitStream& bitStream, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(bitStream.readByte()) << (i * 8);
+    }
+    return value;
+}
+
+// 从文件按小端序读取 bytes 个字节
+uint64_t readLE(std::istream& in, size_t bytes) {
+    uint8_t buffer[8];
+    in.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(bytes));
+    if (!in) {
+        throw std::runtime_error("Unexpected end of file while reading archive");
+    }
+    return loadLE(buffer, bytes);
+}
+
+// 把 tail 写回文件的 offset 处并截断到其末尾（追加失败后恢复旧索引）
+void restoreTail(const std::string& filePath, uint64_t offset, const std::vector<uint8_t>& tail) {
+    int fd = open(filePath.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to restore archive index: " + filePath);
+    }
+    size_t written = 0;
+    while (written < tail.size()) {
+        ssize_t count = pwrite(fd, tail.data() + written, tail.size() - written,
+                               static_cast<off_t>(offset + written));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(count);
+    }
+    bool failed = written < tail.size() ||
+                  ftruncate(fd, static_cast<off_t>(offset + tail.size())) != 0 || fsync(fd) != 0;
+    if (close(fd) != 0 || failed) {
+        throw std::runtime_error("Failed to restore archive index: " + filePath);
+    }
+}
+
+}
 
 // 构造函数
 HuffmanCompressor::HuffmanCompressor()
-    : stats_{0, 0, 0.0, 0.0} {
+    : stats_()
+    , statsFormat_(StatsFormat::TEXT)
+    , statsOutput_(nullptr)
+    , options_(CompressionOptions::preset(Level::DEFAULT))
+    , contentHash_(false)
+    , syncOutput_(false)
+    , threadCount_(0)
+    , flushInterval_(0)
+    , volumeSize_(0) {
 }
 
 // 压缩单个文件
 void HuffmanCompressor::compressFile(const std::string& inputFile,
                                      const std::string& outputFile) {
-    auto startTime = std::chrono::high_resolution_clock::now();
+    auto startTime = Clock::now();
+    resetStats("compress-file");
 
     // 验证输入
     if (inputFile.empty() || outputFile.empty()) {
@@ -30,86 +243,72 @@ void HuffmanCompressor::compressFile(const std::string& inputFile,
         throw std::runtime_error("Input file does not exist: " + inputFile);
     }
 
-    // 统计字符频率
-    std::unordered_map<char, size_t> frequencyMap = calculateFrequency(inputFile);
-
-    // 构建哈夫曼树
-    huffmanTree_.buildTree(frequencyMap);
-    huffmanTree_.generateCodes();
-
-    // 序列化哈夫曼树
-    std::vector<uint8_t> treeData = huffmanTree_.serialize();
+    // 两遍模式：先统计整个文件的字符频率，构建共享哈夫曼树
+    std::vector<uint8_t> treeData;
+    if (!options_.singlePass) {
+        std::unordered_map<char, size_t> frequencyMap = calculateFrequency(inputFile);
+
+        // 构建哈夫曼树
+        auto phaseStart = Clock::now();
+        huffmanTree_.buildTree(frequencyMap, options_.maxCodeLength);
+        stats_.phases.treeBuild += secondsSince(phaseStart);
+
+        // 生成编码表并序列化哈夫曼树
+        phaseStart = Clock::now();
+        huffmanTree_.generateCodes();
+        treeData = huffmanTree_.serialize();
+        stats_.phases.codeGeneration += secondsSince(phaseStart);
+    }
 
     // 获取原始文件大小
-    size_t originalSize = std::filesystem::file_size(inputFile);
+    uint64_t originalSize = std::filesystem::file_size(inputFile);
 
-    // 写入文件头和哈夫曼树
-    std::ofstream outFile(outputFile, std::ios::binary);
-    if (!outFile) {
-        throw std::runtime_error("Failed to open output file: " + outputFile);
-    }
+    // 写入文件头和哈夫曼树（由写线程异步落盘）
+    std::unique_ptr<BlockWriter> archiveWriter = openArchiveWriter(outputFile);
+    BlockWriter& writer = *archiveWriter;
 
     // 写入文件头（单文件模式）
-    std::string inputFileName = std::filesystem::path(inputFile).filename().string();
-    writeHeader(outFile, inputFileName, originalSize, treeData.size(), 0, false);
-
-    // 写入哈夫曼树
-    outFile.write(reinterpret_cast<const char*>(treeData.data()), treeData.size());
-
-    // 压缩并写入数据
-    std::ifstream inFile(inputFile, std::ios::binary);
-    if (!inFile) {
-        outFile.close();
-        throw std::runtime_error("Failed to open input file: " + inputFile);
-    }
-
-    // 使用缓冲区收集压缩的位
-    uint8_t buffer = 0;
-    size_t bitPosition = 0;
-
-    char ch;
-    while (inFile.get(ch)) {
-        std::string code = huffmanTree_.encode(ch);
-        for (char bit : code) {
-            if (bit == '1') {
-                buffer |= (1 << (7 - bitPosition));
-            }
-            bitPosition++;
-
-            if (bitPosition == 8) {
-                outFile.write(reinterpret_cast<const char*>(&buffer), 1);
-                buffer = 0;
-                bitPosition = 0;
-            }
-        }
+    std::string inputFileName = memberName_.empty() ? std::filesystem::path(inputFile).filename().string()
+                                                    : memberName_;
+    writeHeader(writer, inputFileName, originalSize, treeData.size(), 0,
+                options_.singlePass ? ARCHIVE_BLOCKED_FILE : ARCHIVE_FILE);
+
+    // 写入哈夫曼树（单遍模式下为空）
+    writer.write(treeData.data(), treeData.size());
+    uint64_t dataStart = writer.getPosition();
+
+    // 压缩并写入数据：读线程预读下一块，当前线程编码，写线程落盘
+    BitStream bitStream(writer);
+    if (options_.singlePass) {
+        encodeFileSinglePass(inputFile, writer, bitStream);
+    } else {
+        encodeFile(inputFile, bitStream);
     }
 
     // 写入最后不完整的字节
-    if (bitPosition > 0) {
-        outFile.write(reinterpret_cast<const char*>(&buffer), 1);
-    }
+    bitStream.flush();
+    stats_.phases.encode -= writer.getWaitTime();
+    uint64_t dataSize = writer.getPosition() - dataStart;
 
-    inFile.close();
-    outFile.close();
+    writer.finish();
+    recordWriter(writer);
+
+    // 回填压缩数据大小，解压时据此校验归档完整性
+    patchHeader(firstVolumeOf(outputFile), originalSize, dataSize);
 
     // 计算统计信息
-    auto endTime = std::chrono::high_resolution_clock::now();
     stats_.originalSize = std::filesystem::file_size(inputFile);
-    stats_.compressedSize = std::filesystem::file_size(outputFile);
-    stats_.compressionRatio = (static_cast<double>(stats_.compressedSize) / stats_.originalSize) * 100.0;
-    stats_.compressionTime = std::chrono::duration<double>(endTime - startTime).count();
-
-    std::cout << "Compression completed!" << std::endl;
-    std::cout << "Original size: " << stats_.originalSize << " bytes" << std::endl;
-    std::cout << "Compressed size: " << stats_.compressedSize << " bytes" << std::endl;
-    std::cout << "Compression ratio: " << stats_.compressionRatio << "%" << std::endl;
-    std::cout << "Compression time: " << stats_.compressionTime << " seconds" << std::endl;
+    stats_.compressedSize = writer.getPosition();
+    stats_.filesProcessed = 1;
+    finalizeStats(secondsSince(startTime));
+    printStats(std::cout);
 }
 
 // 压缩目录
 void HuffmanCompressor::compressDirectory(const std::string& inputDir,
                                           const std::string& outputFile) {
-    auto startTime = std::chrono::high_resolution_clock::now();
+    auto startTime = Clock::now();
+    resetStats("compress-dir");
 
     // 验证输入
     if (!std::filesystem::exists(inputDir)) {
@@ -120,390 +319,2263 @@ void HuffmanCompressor::compressDirectory(const std::string& inputDir,
         throw std::invalid_argument("Input path is not a directory: " + inputDir);
     }
 
+    // 增量模式下输出不能覆盖作为基准的旧归档
+    if (!incrementalBase_.empty() && std::filesystem::exists(outputFile) &&
+        std::filesystem::equivalent(incrementalBase_, outputFile)) {
+        throw std::invalid_argument("Output file must differ from the incremental base archive");
+    }
+
     // 遍历目录
+    auto phaseStart = Clock::now();
     std::vector<FileEntry> fileEntries = traverseDirectory(inputDir);
+    stats_.phases.traversal += secondsSince(phaseStart);
 
-    // 统计所有文件的字符频率
-    std::unordered_map<char, size_t> totalFrequencyMap;
-    for (const auto& entry : fileEntries) {
-        if (!entry.isDirectory()) {
-            std::string fullPath = inputDir + "/" + entry.getRelativePath();
-            auto freqMap = calculateFrequency(fullPath);
-            for (const auto& pair : freqMap) {
-                totalFrequencyMap[pair.first] += pair.second;
-            }
+    if (contentHash_) {
+        computeContentHashes(inputDir, fileEntries);
+    }
+
+    // 增量模式：找出可原样复制的旧数据块，其余文件需要重新压缩
+    IncrementalPlan plan;
+    if (!incrementalBase_.empty()) {
+        plan = planIncremental(fileEntries);
+    } else {
+        plan.reused.assign(fileEntries.size(), false);
+    }
+
+    std::vector<FileEntry> pendingEntries;
+    std::vector<size_t> pendingIndices;
+    for (size_t i = 0; i < fileEntries.size(); ++i) {
+        if (!fileEntries[i].isDirectory() && !plan.reused[i]) {
+            pendingEntries.push_back(fileEntries[i]);
+            pendingIndices.push_back(i);
         }
     }
 
-    // 构建哈夫曼树
-    huffmanTree_.buildTree(totalFrequencyMap);
-    huffmanTree_.generateCodes();
+    // 非固实模式：统计待压缩文件的字符频率，构建共享哈夫曼树
+    std::vector<uint8_t> treeData;
+    if (!options_.solid) {
+        std::unordered_map<char, size_t> totalFrequencyMap;
+        for (const auto& entry : pendingEntries) {
+            {
+                std::string fullPath = inputDir + "/" + entry.getRelativePath();
+                auto freqMap = calculateFrequency(fullPath);
+                for (const auto& pair : freqMap) {
+                    totalFrequencyMap[pair.first] += pair.second;
+                }
+            }
+        }
 
-    // 序列化哈夫曼树
-    std::vector<uint8_t> treeData = huffmanTree_.serialize();
+        // 全部为空文件时不需要编码表
+        if (!totalFrequencyMap.empty()) {
+            phaseStart = Clock::now();
+            huffmanTree_.buildTree(totalFrequencyMap, options_.maxCodeLength);
+            stats_.phases.treeBuild += secondsSince(phaseStart);
 
-    // 写入压缩文件
-    std::ofstream outFile(outputFile, std::ios::binary);
-    if (!outFile) {
-        throw std::runtime_error("Failed to open output file: " + outputFile);
+            phaseStart = Clock::now();
+            huffmanTree_.generateCodes();
+            treeData = huffmanTree_.serialize();
+            stats_.phases.codeGeneration += secondsSince(phaseStart);
+        }
     }
 
+    // 写入压缩文件
+    std::unique_ptr<BlockWriter> archiveWriter = openArchiveWriter(outputFile);
+    BlockWriter& writer = *archiveWriter;
+
     // 写入文件头
-    size_t totalOriginalSize = 0;
+    uint64_t totalOriginalSize = 0;
     for (const auto& entry : fileEntries) {
         totalOriginalSize += entry.getFileSize();
     }
 
-    writeHeader(outFile, inputDir, totalOriginalSize, treeData.size(), 0, true);
+    writeHeader(writer, inputDir, totalOriginalSize, treeData.size(), 0, ARCHIVE_DIRECTORY);
 
-    // 写入哈夫曼树
-    outFile.write(reinterpret_cast<const char*>(treeData.data()), treeData.size());
+    // 写入共享哈夫曼树（固实模式下为空）
+    writer.write(treeData.data(), treeData.size());
+    uint64_t dataStart = writer.getPosition();
 
-    // 写入文件条目数量
-    uint32_t entryCount = static_cast<uint32_t>(fileEntries.size());
-    outFile.write(reinterpret_cast<const char*>(&entryCount), 4);
+    // 先复制未变化的旧数据块
+    copyReusedBlocks(plan, fileEntries, writer);
 
-    // 写入文件条目
-    for (const auto& entry : fileEntries) {
-        auto entryData = entry.serialize();
-        outFile.write(reinterpret_cast<const char*>(entryData.data()), entryData.size());
+    // 压缩并写入数据块，每个数据块按字节对齐
+    BitStream bitStream(writer);
+    if (options_.solid) {
+        writeSolidBlocks(inputDir, pendingEntries, writer, bitStream);
+    } else {
+        writeSharedTableBlocks(inputDir, pendingEntries, writer, bitStream);
     }
+    stats_.phases.encode -= writer.getWaitTime();
 
-    // 压缩并写入文件数据
-    for (const auto& entry : fileEntries) {
-        if (!entry.isDirectory()) {
-            std::string fullPath = inputDir + "/" + entry.getRelativePath();
-
-            BitStream bitStream(outputFile, BitStream::Mode::WRITE);
-            std::ifstream inFile(fullPath, std::ios::binary);
-
-            char ch;
-            while (inFile.get(ch)) {
-                std::string code = huffmanTree_.encode(ch);
-                for (char bit : code) {
-                    bitStream.writeBit(bit == '1');
-                }
-            }
-
-            bitStream.flush();
-            bitStream.close();
-        }
+    for (size_t i = 0; i < pendingEntries.size(); ++i) {
+        fileEntries[pendingIndices[i]] = pendingEntries[i];
     }
 
-    outFile.close();
+    // 数据块之后写入目录索引
+    uint64_t dataSize = writer.getPosition() - dataStart;
+    writeIndex(writer, fileEntries);
+
+    writer.finish();
+    recordWriter(writer);
+    patchHeader(firstVolumeOf(outputFile), totalOriginalSize, dataSize);
 
     // 计算统计信息
-    auto endTime = std::chrono::high_resolution_clock::now();
     stats_.originalSize = totalOriginalSize;
-    stats_.compressedSize = std::filesystem::file_size(outputFile);
-    stats_.compressionRatio = (static_cast<double>(stats_.compressedSize) / stats_.originalSize) * 100.0;
-    stats_.compressionTime = std::chrono::duration<double>(endTime - startTime).count();
-
-    std::cout << "Directory compression completed!" << std::endl;
-    std::cout << "Files compressed: " << fileEntries.size() << std::endl;
-    std::cout << "Original size: " << stats_.originalSize << " bytes" << std::endl;
-    std::cout << "Compressed size: " << stats_.compressedSize << " bytes" << std::endl;
-    std::cout << "Compression ratio: " << stats_.compressionRatio << "%" << std::endl;
-    std::cout << "Compression time: " << stats_.compressionTime << " seconds" << std::endl;
+    stats_.compressedSize = writer.getPosition();
+    stats_.filesProcessed = fileEntries.size();
+    finalizeStats(secondsSince(startTime));
+    printStats(std::cout);
 }
 
-// 解压
-void HuffmanCompressor::decompress(const std::string& inputFile,
-                                   const std::string& outputDir) {
-    auto startTime = std::chrono::high_resolution_clock::now();
+// 向已有目录归档追加文件或目录
+void HuffmanCompressor::appendToArchive(const std::string& archiveFile,
+                                        const std::vector<std::string>& inputPaths) {
+    auto startTime = Clock::now();
+    resetStats("append");
 
     // 验证输入
-    if (!std::filesystem::exists(inputFile)) {
-        throw std::runtime_error("Input file does not exist: " + inputFile);
+    if (inputPaths.empty()) {
+        throw std::invalid_argument("No input paths to append");
     }
 
-    // 创建输出目录
-    createDirectory(outputDir);
+    // 追加需要原地改写归档末尾的目录索引，分卷归档不支持
+    if (volumeSize_ > 0) {
+        throw std::invalid_argument("Append does not support multi-volume output");
+    }
+    if (VolumeSet::isMultiVolume(archiveFile, volumeDirs_)) {
+        throw std::runtime_error("Cannot append to a multi-volume archive: " + archiveFile);
+    }
 
-    // 读取文件头
-    std::ifstream inFile(inputFile, std::ios::binary);
+    if (!std::filesystem::exists(archiveFile)) {
+        throw std::runtime_error("Archive does not exist: " + archiveFile);
+    }
+
+    // 读取文件头和目录索引
+    std::ifstream inFile(archiveFile, std::ios::binary);
     if (!inFile) {
-        throw std::runtime_error("Failed to open input file: " + inputFile);
+        throw std::runtime_error("Failed to open archive: " + archiveFile);
     }
 
     std::string originalPath;
-    size_t originalSize, treeSize, dataSize;
-    bool isDirectory;
+    uint64_t originalSize, treeSize, dataSize;
+    uint8_t archiveType;
+    readHeader(inFile, originalPath, originalSize, treeSize, dataSize, archiveType);
+    if (archiveType != ARCHIVE_DIRECTORY) {
+        throw std::runtime_error("Can only append to a directory archive: " + archiveFile);
+    }
+    uint64_t dataStart = static_cast<uint64_t>(inFile.tellg()) + treeSize;
 
-    readHeader(inFile, originalPath, originalSize, treeSize, dataSize, isDirectory);
+    uint64_t indexOffset;
+    std::vector<FileEntry> fileEntries = readIndex(inFile, indexOffset);
 
-    // 读取哈夫曼树
-    std::vector<uint8_t> treeData(treeSize);
-    inFile.read(reinterpret_cast<char*>(treeData.data()), treeSize);
+    // 新数据块从旧索引处开始写入，先保存旧索引和尾部，追加失败时据此恢复
+    inFile.seekg(0, std::ios::end);
+    std::vector<uint8_t> oldTail(static_cast<size_t>(static_cast<uint64_t>(inFile.tellg()) - indexOffset));
+    inFile.seekg(static_cast<std::streamoff>(indexOffset));
+    inFile.read(reinterpret_cast<char*>(oldTail.data()), static_cast<std::streamsize>(oldTail.size()));
+    if (!inFile) {
+        throw std::runtime_error("Unexpected end of file while reading archive index");
+    }
+    inFile.close();
 
-    size_t offset = 0;
-    huffmanTree_.deserialize(treeData, offset);
+    std::set<std::string> existingPaths;
+    for (const auto& entry : fileEntries) {
+        existingPaths.insert(entry.getRelativePath());
+    }
 
-    if (isDirectory) {
-        // 读取文件条目数量
-        uint32_t entryCount;
-        inFile.read(reinterpret_cast<char*>(&entryCount), 4);
+    // 收集新成员：文件以文件名入档，目录以目录名为前缀递归入档
+    auto phaseStart = Clock::now();
+    std::vector<std::pair<std::string, std::vector<FileEntry>>> groups;
+    for (const auto& inputPath : inputPaths) {
+        std::filesystem::path path = std::filesystem::path(inputPath).lexically_normal();
+        if (!path.has_filename()) {
+            path = path.parent_path();
+        }
+        if (!std::filesystem::exists(path)) {
+            throw std::runtime_error("Input path does not exist: " + inputPath);
+        }
 
-        // 读取文件条目
-        std::vector<FileEntry> fileEntries;
-        for (uint32_t i = 0; i < entryCount; ++i) {
-            FileEntry entry;
-            std::vector<uint8_t> entryData;
+        std::string name = path.filename().string();
+        std::string baseDir = path.has_parent_path() ? path.parent_path().string() : ".";
 
-            // 读取条目大小（这里简化处理，实际应该先读取大小）
-            // 实际实现中需要更复杂的逻辑来确定条目边界
-            offset = 0;
-            entry.deserialize(entryData, offset);
-            fileEntries.push_back(entry);
+        std::vector<FileEntry> newEntries;
+        if (std::filesystem::is_directory(path)) {
+            newEntries.emplace_back(name, 0, true);
+            for (auto& entry : traverseDirectory(path.string())) {
+                entry.setRelativePath(name + "/" + entry.getRelativePath());
+                newEntries.push_back(entry);
+            }
+        } else {
+            newEntries.emplace_back(name, std::filesystem::file_size(path), false);
+            newEntries.back().setModifiedTime(modifiedTimeOf(path));
         }
 
-        // 解压文件
-        BitStream bitStream(inputFile, BitStream::Mode::READ);
-        HuffmanNode* root = huffmanTree_.getRoot();
+        if (contentHash_) {
+            computeContentHashes(baseDir, newEntries);
+        }
 
-        for (const auto& entry : fileEntries) {
-            if (entry.isDirectory()) {
-                std::string dirPath = outputDir + "/" + entry.getRelativePath();
-                createDirectory(dirPath);
-            } else {
-                std::string filePath = outputDir + "/" + entry.getRelativePath();
-                std::string dirPath = filePath.substr(0, filePath.find_last_of('/'));
-                createDirectory(dirPath);
+        for (const auto& entry : newEntries) {
+            if (!existingPaths.insert(entry.getRelativePath()).second) {
+                throw std::runtime_error("Archive already contains: " + entry.getRelativePath());
+            }
+        }
 
-                std::ofstream outFile(filePath, std::ios::binary);
+        groups.emplace_back(baseDir, std::move(newEntries));
+    }
+    stats_.phases.traversal += secondsSince(phaseStart);
+
+    // 从旧索引位置开始写入新数据块，已有数据块保持不变
+    // 中途失败（如输入文件无法读取、磁盘已满）时写回旧索引和尾部、恢复原长度和文件头，归档回到追加前的状态
+    uint64_t appendedSize = 0;
+    try {
+        BlockWriter writer(archiveFile, BlockWriter::OpenMode::OVERWRITE, indexOffset);
+        BitStream bitStream(writer);
+
+        for (auto& group : groups) {
+            writeSolidBlocks(group.first, group.second, writer, bitStream);
+            for (const auto& entry : group.second) {
+                appendedSize += entry.getFileSize();
+                fileEntries.push_back(entry);
+            }
+            stats_.filesProcessed += group.second.size();
+        }
+        stats_.phases.encode -= writer.getWaitTime();
 
-                HuffmanNode* current = root;
-                size_t bytesWritten = 0;
+        // 重写目录索引和尾部
+        uint64_t newDataSize = writer.getPosition() - dataStart;
+        writeIndex(writer, fileEntries);
 
-                while (bytesWritten < entry.getFileSize()) {
-                    bool bit = bitStream.readBit();
+        writer.finish();
+        recordWriter(writer);
 
-                    if (bit) {
-                        current = current->getRight();
-                    } else {
-                        current = current->getLeft();
-                    }
+        // 更新文件头中的原始总大小和数据大小
+        patchHeader(archiveFile, originalSize + appendedSize, newDataSize);
+    } catch (...) {
+        restoreTail(archiveFile, indexOffset, oldTail);
+        patchHeader(archiveFile, originalSize, dataSize);
+        throw;
+    }
 
-                    if (current->isLeaf()) {
-                        outFile.put(current->getCharacter());
-                        current = root;
-                        bytesWritten++;
-                    }
-                }
+    // 计算统计信息
+    stats_.originalSize = appendedSize;
+    stats_.compressedSize = std::filesystem::file_size(archiveFile) - indexOffset;
+    finalizeStats(secondsSince(startTime));
+    printStats(std::cout);
+}
 
-                outFile.close();
-            }
-        }
+// 解压
+void HuffmanCompressor::decompress(const std::string& inputFile,
+                                   const std::string& outputDir) {
+    decompressArchive(inputFile, outputDir, std::string());
+}
 
-        bitStream.close();
+// 解压单文件归档到指定文件
+void HuffmanCompressor::decompressFile(const std::string& inputFile, const std::string& outputFile) {
+    decompressArchive(inputFile, std::string(), outputFile);
+}
+
+// 解压：outputFile 非空时单文件归档写入 outputFile，否则写入 outputDir 下归档记录的文件名
+void HuffmanCompressor::decompressArchive(const std::string& inputFile, const std::string& outputDir,
+                                          const std::string& outputFile) {
+    auto startTime = Clock::now();
+    resetStats("decompress");
+
+    // 分卷归档：给出的路径不存在而能找到第一个卷，或直接给出第一个卷
+    std::unique_ptr<VolumeSet> volumes;
+    if (VolumeSet::isMultiVolume(inputFile, volumeDirs_)) {
+        volumes.reset(new VolumeSet(inputFile, volumeDirs_));
+    } else if (!std::filesystem::exists(inputFile)) {
+        throw std::runtime_error("Input file does not exist: " + inputFile);
+    }
+
+    // 创建输出目录
+    if (outputFile.empty()) {
+        createDirectory(outputDir);
+    }
+
+    // 读取文件头
+    std::unique_ptr<std::istream> input;
+    if (volumes) {
+        input.reset(new VolumeSet::Stream(*volumes));
     } else {
-        // 单文件解压
-        HuffmanNode* root = huffmanTree_.getRoot();
+        input.reset(new std::ifstream(inputFile, std::ios::binary));
+    }
+    std::istream& inFile = *input;
+    if (!inFile) {
+        throw std::runtime_error("Failed to open input file: " + inputFile);
+    }
 
-        // 创建输出文件
-        std::ofstream outFile(outputDir + "/" + originalPath, std::ios::binary);
-        if (!outFile) {
-            throw std::runtime_error("Failed to create output file: " + outputDir + "/" + originalPath);
-        }
+    std::string originalPath;
+    uint64_t originalSize, treeSize, dataSize;
+    uint8_t archiveType;
+
+    readHeader(inFile, originalPath, originalSize, treeSize, dataSize, archiveType);
+
+    // 文件头之后依次为编码表和 dataSize 字节的压缩数据，大小对不上说明归档被截断或损坏
+    uint64_t archiveSize = volumes ? volumes->size() : std::filesystem::file_size(inputFile);
+    uint64_t dataStart = static_cast<uint64_t>(inFile.tellg()) + treeSize;
+    // 流式归档写到管道时无法回填大小字段，数据大小为 0 表示未知，以 END 符号为准
+    uint64_t payloadEnd = archiveType == ARCHIVE_DIRECTORY ? archiveSize - 12 : archiveSize;
+    bool sizeKnown = archiveType != ARCHIVE_STREAM || dataSize != 0;
+    if (treeSize > MAX_TABLE_SIZE || dataStart > payloadEnd || dataSize > payloadEnd - dataStart ||
+        (archiveType == ARCHIVE_STREAM && treeSize != 0) ||
+        (archiveType != ARCHIVE_DIRECTORY && sizeKnown && dataStart + dataSize != archiveSize)) {
+        throw std::runtime_error("Corrupted archive: size fields do not match file size");
+    }
 
-        HuffmanNode* current = root;
-        size_t bytesWritten = 0;
+    // 读取哈夫曼树（固实目录归档没有共享编码表）
+    auto phaseStart = Clock::now();
+    huffmanTree_.clear();
+    if (treeSize > 0) {
+        std::vector<uint8_t> treeData(treeSize);
+        inFile.read(reinterpret_cast<char*>(treeData.data()), static_cast<std::streamsize>(treeSize));
+        if (!inFile) {
+            throw std::runtime_error("Unexpected end of file while reading Huffman table");
+        }
 
-        // 从 inFile 当前位置读取压缩数据
-        uint8_t buffer = 0;
-        size_t bitPosition = 0;
+        size_t offset = 0;
+        huffmanTree_.deserialize(treeData, offset);
+    }
+    stats_.phases.treeBuild += secondsSince(phaseStart);
 
-        while (bytesWritten < originalSize) {
-            // 读取下一个字节（如果需要）
-            if (bitPosition == 0) {
-                if (!inFile.read(reinterpret_cast<char*>(&buffer), 1)) {
-                    throw std::runtime_error("Unexpected end of file while decompressing");
-                }
-            }
+    double ioWaitBefore = stats_.phases.ioWait;
 
-            // 读取一个位（从高位到低位）
-            bool bit = (buffer & (1 << (7 - bitPosition))) != 0;
-            bitPosition++;
-            if (bitPosition == 8) {
-                bitPosition = 0;
-            }
+    if (archiveType == ARCHIVE_DIRECTORY && !outputFile.empty()) {
+        throw std::invalid_argument("Directory archives must be extracted to a directory");
+    }
 
-            // 遍历哈夫曼树
-            if (bit) {
-                current = current->getRight();
-            } else {
-                current = current->getLeft();
-            }
+    if (archiveType == ARCHIVE_DIRECTORY) {
+        // 读取归档末尾的目录索引
+        uint64_t indexOffset;
+        std::vector<FileEntry> fileEntries = readIndex(inFile, indexOffset);
+        if (indexOffset != dataStart + dataSize) {
+            throw std::runtime_error("Corrupted archive: index does not follow data blocks");
+        }
 
-            if (current->isLeaf()) {
-                outFile.put(current->getCharacter());
-                current = root;
-                bytesWritten++;
+        phaseStart = Clock::now();
+        extractDirectory(inputFile, volumes.get(), fileEntries, outputDir);
+    } else {
+        // 单文件解压：读线程从压缩数据起点开始预读
+        phaseStart = Clock::now();
+        uint64_t payloadStart = static_cast<uint64_t>(inFile.tellg());
+        std::unique_ptr<BlockReader> payloadReader(volumes ? new BlockReader(*volumes, payloadStart)
+                                                           : new BlockReader(inputFile, payloadStart));
+        BlockReader& reader = *payloadReader;
+        BitStream bitStream(reader);
+
+        std::string outputPath = outputFile.empty() ? outputDir + "/" + originalPath : outputFile;
+        if (archiveType == ARCHIVE_BLOCKED_FILE) {
+            decodeBlockedFile(bitStream, originalSize, outputPath);
+        } else if (archiveType == ARCHIVE_STREAM) {
+            BlockWriter writer(outputPath);
+            writer.setSync(syncOutput_);
+            writer.preallocate(originalSize);
+            uint64_t decoded = decodeAdaptive(bitStream, writer, false);
+            writer.finish();
+            recordWriter(writer);
+            if (sizeKnown && decoded != originalSize) {
+                throw std::runtime_error("Corrupted archive: decoded size does not match header");
             }
+        } else {
+            decodeFile(prepareDecoder(huffmanTree_), bitStream, originalSize, outputPath);
         }
+        stats_.filesProcessed = 1;
 
-        outFile.close();
+        recordReader(reader);
     }
+    stats_.phases.decode += secondsSince(phaseStart) - (stats_.phases.ioWait - ioWaitBefore);
 
-    inFile.close();
+    input.reset();
 
     // 计算统计信息
-    auto endTime = std::chrono::high_resolution_clock::now();
     stats_.originalSize = originalSize;
-    stats_.compressedSize = std::filesystem::file_size(inputFile);
-    stats_.compressionRatio = (static_cast<double>(stats_.compressedSize) / stats_.originalSize) * 100.0;
-    stats_.compressionTime = std::chrono::duration<double>(endTime - startTime).count();
-
-    std::cout << "Decompression completed!" << std::endl;
-    std::cout << "Decompressed size: " << stats_.originalSize << " bytes" << std::endl;
-    std::cout << "Decompression time: " << stats_.compressionTime << " seconds" << std::endl;
-}
-
-// 获取统计信息
-HuffmanCompressor::CompressionStats HuffmanCompressor::getCompressionStats() const {
-    return stats_;
+    stats_.compressedSize = archiveSize;
+    stats_.bytesProcessed = originalSize;
+    stats_.payloadBits = stats_.bytesRead * 8;
+    finalizeStats(secondsSince(startTime));
+    printStats(std::cout);
 }
 
-// 计算字符频率
-std::unordered_map<char, size_t> HuffmanCompressor::calculateFrequency(const std::string& filePath) {
-    std::unordered_map<char, size_t> frequencyMap;
+// 流式压缩：逐个符号更新自适应模型，输出不等待整块
+// 格式：文件头（类型 ARCHIVE_STREAM，无编码表）+ 位流，位流中的 FLUSH 符号之后补齐到字节边界，以 END 符号结束
+void HuffmanCompressor::compressStream(const std::string& input, const std::string& output) {
+    auto startTime = Clock::now();
+    resetStats("compress-stream");
 
-    std::ifstream inFile(filePath, std::ios::binary);
-    if (!inFile) {
-        throw std::runtime_error("Failed to open file: " + filePath);
+    // 流式归档边写边输出，最终大小未知，不能预先按卷切分
+    if (volumeSize_ > 0) {
+        throw std::invalid_argument("Stream compression does not support multi-volume output");
     }
 
-    char ch;
-    while (inFile.get(ch)) {
-        frequencyMap[ch]++;
+    if (input.empty() || output.empty()) {
+        throw std::invalid_argument("File paths cannot be empty");
     }
 
-    inFile.close();
+    // 读写都不经过后台线程：读到多少编码多少，刷新点的数据立即写出
+    BlockReader reader(input == "-" ? "/dev/stdin" : input, 0, STREAM_CHUNK_SIZE, 0);
+    BlockWriter writer(output == "-" ? "/dev/stdout" : output, BlockWriter::DEFAULT_BLOCK_SIZE, 0);
+
+    std::string name = !memberName_.empty() ? memberName_
+                     : input == "-" ? "stdin" : std::filesystem::path(input).filename().string();
+    writeHeader(writer, name, 0, 0, 0, ARCHIVE_STREAM);
+    uint64_t dataStart = writer.getPosition();
+
+    BitStream bitStream(writer);
+    AdaptiveHuffman model;
+    uint64_t sinceFlush = 0;
+    const uint8_t* data;
+    size_t size;
+    while (reader.next(data, size)) {
+        HUFFZIP_TRACE_SPAN("encode");
+        auto phaseStart = Clock::now();
+        for (size_t i = 0; i < size; ++i) {
+            model.encode(data[i], bitStream);
+        }
+        stats_.bytesProcessed += size;
+        sinceFlush += size;
 
-    return frequencyMap;
-}
+        // 读到的不足一块说明输入暂时没有更多数据，此时或达到刷新间隔时输出刷新点
+        if (size < STREAM_CHUNK_SIZE || (flushInterval_ > 0 && sinceFlush >= flushInterval_)) {
+            model.encode(AdaptiveHuffman::FLUSH_SYMBOL, bitStream);
+            bitStream.flush();
+            writer.flush();
+            sinceFlush = 0;
+        }
+        stats_.phases.encode += secondsSince(phaseStart);
+    }
 
-// 写入文件头
-void HuffmanCompressor::writeHeader(std::ofstream& outFile, const std::string& inputPath,
-                                     size_t originalSize, size_t treeSize, size_t dataSize,
-                                     bool isDirectory) {
-    // 魔数（4字节）
-    outFile.write(reinterpret_cast<const char*>(&MAGIC_NUMBER), 4);
+    model.encode(AdaptiveHuffman::END_SYMBOL, bitStream);
+    bitStream.flush();
+    uint64_t dataSize = writer.getPosition() - dataStart;
+    uint64_t archiveSize = writer.getPosition();
+    writer.finish();
+    recordReader(reader);
+    recordWriter(writer);
+
+    // 输出为普通文件时回填大小字段，解压时据此校验完整性
+    if (output != "-" && std::filesystem::is_regular_file(output)) {
+        patchHeader(output, stats_.bytesProcessed, dataSize);
+    }
 
-    // 版本号（1字节）
-    outFile.write(reinterpret_cast<const char*>(&VERSION), 1);
+    stats_.originalSize = stats_.bytesProcessed;
+    stats_.compressedSize = archiveSize;
+    stats_.payloadBits = dataSize * 8;
+    stats_.filesProcessed = 1;
+    finalizeStats(secondsSince(startTime));
+    printStats(output == "-" ? std::cerr : std::cout);
+}
 
-    // 原始大小（8字节）
-    uint64_t originalSize64 = static_cast<uint64_t>(originalSize);
-    outFile.write(reinterpret_cast<const char*>(&originalSize64), 8);
+// 流式解压：文件头也从同一个流中读取，输入可以是管道
+void HuffmanCompressor::decompressStream(const std::string& input, const std::string& output) {
+    auto startTime = Clock::now();
+    resetStats("decompress-stream");
 
-    // 树大小（4字节）
-    uint32_t treeSize32 = static_cast<uint32_t>(treeSize);
-    outFile.write(reinterpret_cast<const char*>(&treeSize32), 4);
+    if (input.empty() || output.empty()) {
+        throw std::invalid_argument("File paths cannot be empty");
+    }
 
-    // 数据大小（4字节）
-    uint32_t dataSize32 = static_cast<uint32_t>(dataSize);
-    outFile.write(reinterpret_cast<const char*>(&dataSize32), 4);
+    BlockReader reader(input == "-" ? "/dev/stdin" : input, 0, STREAM_CHUNK_SIZE, 0);
+    BitStream bitStream(reader);
 
-    // 类型标志（1字节）
-    uint8_t typeFlag = isDirectory ? 1 : 0;
-    outFile.write(reinterpret_cast<const char*>(&typeFlag), 1);
+    std::string originalPath;
+    uint64_t originalSize, treeSize, dataSize;
+    uint8_t archiveType;
+    readHeader(bitStream, originalPath, originalSize, treeSize, dataSize, archiveType);
+    if (archiveType != ARCHIVE_STREAM || treeSize != 0) {
+        throw std::runtime_error("Not a stream archive, use decompress instead");
+    }
 
-    // 文件名长度（2字节）
-    uint16_t pathLength = static_cast<uint16_t>(inputPath.length());
-    outFile.write(reinterpret_cast<const char*>(&pathLength), 2);
+    auto phaseStart = Clock::now();
+    BlockWriter writer(output == "-" ? "/dev/stdout" : output, BlockWriter::DEFAULT_BLOCK_SIZE, 0);
+    uint64_t decoded = decodeAdaptive(bitStream, writer, true);
+    writer.finish();
+    stats_.phases.decode += secondsSince(phaseStart) - reader.getWaitTime();
+    recordReader(reader);
+    recordWriter(writer);
 
-    // 文件名（变长）
-    outFile.write(inputPath.c_str(), pathLength);
+    if (dataSize != 0 && decoded != originalSize) {
+        throw std::runtime_error("Corrupted archive: decoded size does not match header");
+    }
 
-    // 保留字段（2字节，从4字节改为2字节以平衡文件名长度）
-    uint16_t reserved = 0;
-    outFile.write(reinterpret_cast<const char*>(&reserved), 2);
+    stats_.originalSize = decoded;
+    stats_.compressedSize = reader.getBytesRead();
+    stats_.bytesProcessed = decoded;
+    stats_.filesProcessed = 1;
+    finalizeStats(secondsSince(startTime));
+    printStats(output == "-" ? std::cerr : std::cout);
 }
 
-// 读取文件头
-void HuffmanCompressor::readHeader(std::ifstream& inFile, std::string& originalPath,
-                                   size_t& originalSize, size_t& treeSize, size_t& dataSize,
-                                   bool& isDirectory) {
-    // 读取魔数
-    uint32_t magic;
-    inFile.read(reinterpret_cast<char*>(&magic), 4);
-    if (magic != MAGIC_NUMBER) {
-        throw std::runtime_error("Invalid magic number");
+// 自适应解码直到 END 符号，返回解出的字节数
+// flushOutput 为 true 时每个刷新点都把已解出的数据写出，供下游及时读取
+uint64_t HuffmanCompressor::decodeAdaptive(BitStream& bitStream, BlockWriter& writer, bool flushOutput) {
+    HUFFZIP_TRACE_SPAN("decode");
+    AdaptiveHuffman model;
+    uint64_t decoded = 0;
+    while (true) {
+        unsigned symbol = model.decode(bitStream);
+        if (symbol == AdaptiveHuffman::END_SYMBOL) {
+            break;
+        }
+        if (symbol == AdaptiveHuffman::FLUSH_SYMBOL) {
+            bitStream.alignToByte();
+            if (flushOutput) {
+                writer.flush();
+            }
+            continue;
+        }
+        writer.put(static_cast<uint8_t>(symbol));
+        decoded++;
     }
+    stats_.bytesProcessed += decoded;
+    return decoded;
+}
 
-    // 读取版本号
-    uint8_t version;
-    inFile.read(reinterpret_cast<char*>(&version), 1);
-    if (version != VERSION) {
-        throw std::runtime_error("Unsupported version: " + std::to_string(version));
+// 按命令名执行单个操作
+void HuffmanCompressor::execute(const std::string& command, const std::string& input, const std::string& output) {
+    if (command == "compress-file") {
+        compressFile(input, output);
+    } else if (command == "compress-dir") {
+        compressDirectory(input, output);
+    } else if (command == "decompress") {
+        decompress(input, output);
+    } else if (command == "compress-stream") {
+        compressStream(input, output);
+    } else if (command == "decompress-stream") {
+        decompressStream(input, output);
+    } else if (command == "analyze") {
+        // 只读取输入，不写输出
+        analyze(input);
+    } else {
+        throw std::invalid_argument("Unknown command: " + command);
     }
+}
 
-    // 读取原始大小
-    uint64_t originalSize64;
-    inFile.read(reinterpret_cast<char*>(&originalSize64), 8);
-    originalSize = static_cast<size_t>(originalSize64);
+// 抽样估计可压缩性：每个文件按固定数量的样本段统计频率、建表并编码一次
+void HuffmanCompressor::analyze(const std::string& inputPath) {
+    auto startTime = Clock::now();
+    resetStats("analyze");
 
-    // 读取树大小
-    uint32_t treeSize32;
-    inFile.read(reinterpret_cast<char*>(&treeSize32), 4);
-    treeSize = static_cast<size_t>(treeSize32);
+    if (!std::filesystem::exists(inputPath)) {
+        throw std::runtime_error("Input path does not exist: " + inputPath);
+    }
 
-    // 读取数据大小
-    uint32_t dataSize32;
-    inFile.read(reinterpret_cast<char*>(&dataSize32), 4);
-    dataSize = static_cast<size_t>(dataSize32);
+    // 收集待估计的非空文件
+    std::vector<FileEstimate> estimates;
+    std::string baseDir;
+    auto phaseStart = Clock::now();
+    if (std::filesystem::is_directory(inputPath)) {
+        baseDir = inputPath + "/";
+        for (const auto& entry : traverseDirectory(inputPath)) {
+            if (!entry.isDirectory() && entry.getFileSize() > 0) {
+                estimates.push_back(FileEstimate{entry.getRelativePath(), entry.getFileSize(), 0, 0.0, 0, 0.0, false});
+            }
+        }
+    } else {
+        uint64_t size = std::filesystem::file_size(inputPath);
+        if (size > 0) {
+            estimates.push_back(FileEstimate{inputPath, size, 0, 0.0, 0, 0.0, false});
+        }
+    }
+    stats_.phases.traversal += secondsSince(phaseStart);
 
-    // 读取类型标志
-    uint8_t typeFlag;
-    inFile.read(reinterpret_cast<char*>(&typeFlag), 1);
-    isDirectory = (typeFlag != 0);
+    size_t threadCount = threadCount_;
+    if (threadCount == 0) {
+        threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), MAX_EXTRACT_THREADS);
+    }
+    threadCount = std::max<size_t>(1, std::min(threadCount, estimates.size()));
+
+    // 各线程按原子计数领取文件，结果写入各自的槽位
+    std::atomic<size_t> nextFile(0);
+    std::atomic<bool> failed(false);
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    auto worker = [&]() {
+        HUFFZIP_TRACE_THREAD("analyze");
+        try {
+            std::vector<uint8_t> sample;
+            std::vector<std::vector<uint8_t>> streamBuffers(Kernels::STREAM_COUNT);
+            while (!failed) {
+                size_t index = nextFile++;
+                if (index >= estimates.size()) {
+                    break;
+                }
+                HUFFZIP_TRACE_SPAN("estimate");
+                estimateFile(baseDir + estimates[index].path, estimates[index], sample, streamBuffers);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            failed = true;
+        }
+    };
 
-    // 读取文件名长度
-    uint16_t pathLength;
-    inFile.read(reinterpret_cast<char*>(&pathLength), 2);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threadCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
 
-    // 读取文件名
-    std::vector<char> pathBuffer(pathLength + 1, '\0');
-    inFile.read(pathBuffer.data(), pathLength);
-    originalPath = std::string(pathBuffer.data());
+    // 汇总：按全部样本的平均处理速度推算压缩时间（不含磁盘 I/O）
+    double sampleSeconds = 0.0;
+    for (const auto& estimate : estimates) {
+        stats_.originalSize += estimate.originalSize;
+        stats_.compressedSize += estimate.estimatedSize;
+        stats_.bytesSampled += estimate.bytesSampled;
+        sampleSeconds += estimate.sampleSeconds;
+    }
+    stats_.bytesRead = stats_.bytesSampled;
+    stats_.filesProcessed = estimates.size();
+    double secondsPerByte = stats_.bytesSampled > 0 ? sampleSeconds / stats_.bytesSampled : 0.0;
 
-    // 跳过保留字段
-    uint16_t reserved;
-    inFile.read(reinterpret_cast<char*>(&reserved), 2);
+    finalizeStats(secondsSince(startTime));
+    printEstimates(estimates, secondsPerByte, std::cout);
 }
 
-// 遍历目录
-std::vector<FileEntry> HuffmanCompressor::traverseDirectory(const std::string& dirPath) {
-    std::vector<FileEntry> fileEntries;
+// 估计单个文件：读取均匀分布的样本段，用压缩时相同的频率统计、建表和编码内核处理样本
+void HuffmanCompressor::estimateFile(const std::string& filePath, FileEstimate& estimate,
+                                     std::vector<uint8_t>& sample,
+                                     std::vector<std::vector<uint8_t>>& streamBuffers) const {
+    std::ifstream inFile(filePath, std::ios::binary);
+    if (!inFile) {
+        throw std::runtime_error("Failed to open file: " + filePath);
+    }
 
-    for (const auto& entry : std::filesystem::recursive_directory_iterator(dirPath)) {
-        std::string relativePath = getRelativePath(dirPath, entry.path().string());
+    // 小文件整体读取，大文件读取首尾及中间均匀分布的样本段
+    uint64_t fileSize = estimate.originalSize;
+    if (fileSize <= ANALYZE_SAMPLE_SIZE * ANALYZE_SAMPLE_COUNT) {
+        sample.resize(static_cast<size_t>(fileSize));
+        inFile.read(reinterpret_cast<char*>(sample.data()), static_cast<std::streamsize>(sample.size()));
+        sample.resize(static_cast<size_t>(inFile.gcount()));
+    } else {
+        sample.resize(ANALYZE_SAMPLE_SIZE * ANALYZE_SAMPLE_COUNT);
+        size_t filled = 0;
+        for (size_t i = 0; i < ANALYZE_SAMPLE_COUNT; ++i) {
+            uint64_t offset = (fileSize - ANALYZE_SAMPLE_SIZE) * i / (ANALYZE_SAMPLE_COUNT - 1);
+            inFile.clear();
+            inFile.seekg(static_cast<std::streamoff>(offset));
+            inFile.read(reinterpret_cast<char*>(sample.data() + filled), ANALYZE_SAMPLE_SIZE);
+            filled += static_cast<size_t>(inFile.gcount());
+        }
+        sample.resize(filled);
+    }
+    estimate.bytesSampled = sample.size();
+    if (sample.empty()) {
+        return;
+    }
 
-        if (entry.is_directory()) {
-            fileEntries.emplace_back(relativePath, 0, true);
-        } else {
-            fileEntries.emplace_back(relativePath, entry.file_size(), false);
+    auto phaseStart = Clock::now();
+    const Kernels& kernels = CpuDispatch::getKernels();
+    size_t counts[256] = {0};
+    kernels.histogram(sample.data(), sample.size(), counts);
+
+    // 0 阶熵
+    double entropy = 0.0;
+    for (size_t count : counts) {
+        if (count > 0) {
+            double p = static_cast<double>(count) / sample.size();
+            entropy -= p * std::log2(p);
+        }
+    }
+    estimate.entropy = entropy;
+
+    // 按样本建表，由码长得到样本的编码位数
+    HuffmanTree tree;
+    tree.buildTree(toFrequencyMap(counts), options_.maxCodeLength);
+    tree.generateCodes();
+    const uint8_t* codeLengths = tree.getCodeLengths();
+    uint64_t sampleBits = 0;
+    unsigned maxLength = 0;
+    for (int b = 0; b < 256; ++b) {
+        sampleBits += static_cast<uint64_t>(counts[b]) * codeLengths[b];
+        maxLength = std::max<unsigned>(maxLength, codeLengths[b]);
+    }
+    size_t tableSize = tree.serialize().size();
+
+    // 实际编码一次样本，计入耗时以推算整文件的压缩时间
+    if (maxLength <= BitStream::MAX_FAST_CODE_LENGTH) {
+        uint8_t* streams[Kernels::STREAM_COUNT];
+        size_t streamSizes[Kernels::STREAM_COUNT];
+        for (size_t k = 0; k < Kernels::STREAM_COUNT; ++k) {
+            streamBuffers[k].resize(streamCapacity(sample.size(), maxLength));
+            streams[k] = streamBuffers[k].data();
         }
+        kernels.encodeStreams(tree.getCodeBits(), codeLengths, sample.data(), sample.size(),
+                              streams, streamSizes);
     }
+    estimate.sampleSeconds = secondsSince(phaseStart);
 
-    return fileEntries;
+    // 按样本的平均码长推算整个文件
+    double bitsPerByte = static_cast<double>(sampleBits) / sample.size();
+    estimate.estimatedSize = static_cast<uint64_t>(std::ceil(bitsPerByte * fileSize / 8.0)) + tableSize;
+    estimate.incompressible = estimate.estimatedSize >= INCOMPRESSIBLE_RATIO * fileSize;
 }
 
-// 创建目录
-void HuffmanCompressor::createDirectory(const std::string& dirPath) {
-    if (!std::filesystem::exists(dirPath)) {
-        std::filesystem::create_directories(dirPath);
+// 输出 analyze 结果：每个文件一行，最后是汇总；与统计信息一样，设置了输出流时写到该流
+void HuffmanCompressor::printEstimates(const std::vector<FileEstimate>& estimates, double secondsPerByte,
+                                       std::ostream& defaultOut) const {
+    std::ostream& target = statsOutput_ ? *statsOutput_ : defaultOut;
+    size_t incompressibleCount = 0;
+    for (const auto& estimate : estimates) {
+        incompressibleCount += estimate.incompressible ? 1 : 0;
+    }
+    double estimatedTime = secondsPerByte * stats_.originalSize;
+
+    std::ostringstream out;
+    out << std::setprecision(6) << std::fixed;
+    if (statsFormat_ == StatsFormat::JSON) {
+        out << "{\"operation\":\"analyze\""
+            << ",\"isa\":\"" << stats_.isa << "\""
+            << ",\"files\":[";
+        for (size_t i = 0; i < estimates.size(); ++i) {
+            const FileEstimate& estimate = estimates[i];
+            out << (i > 0 ? "," : "")
+                << "{\"path\":\"" << jsonEscape(estimate.path) << "\""
+                << ",\"originalSize\":" << estimate.originalSize
+                << ",\"bytesSampled\":" << estimate.bytesSampled
+                << ",\"entropy\":" << estimate.entropy
+                << ",\"estimatedSize\":" << estimate.estimatedSize
+                << ",\"estimatedTime\":" << secondsPerByte * estimate.originalSize
+                << ",\"incompressible\":" << (estimate.incompressible ? "true" : "false")
+                << "}";
+        }
+        out << "]"
+            << ",\"originalSize\":" << stats_.originalSize
+            << ",\"estimatedSize\":" << stats_.compressedSize
+            << ",\"estimatedRatio\":" << stats_.compressionRatio
+            << ",\"estimatedTime\":" << estimatedTime
+            << ",\"incompressibleFiles\":" << incompressibleCount
+            << ",\"bytesSampled\":" << stats_.bytesSampled
+            << ",\"totalTime\":" << stats_.compressionTime
+            << "}";
+        target << out.str() << std::endl;
+        return;
     }
-}
 
-// 获取相对路径
-std::string HuffmanCompressor::getRelativePath(const std::string& basePath,
-                                                const std::string& fullPath) {
-    // 标准化路径
-    std::filesystem::path base(basePath);
-    std::filesystem::path full(fullPath);
+    for (const auto& estimate : estimates) {
+        double ratio = 100.0 * estimate.estimatedSize / estimate.originalSize;
+        out << estimate.path << ": " << estimate.originalSize << " -> ~" << estimate.estimatedSize
+            << " bytes (" << std::setprecision(1) << ratio << "%, entropy "
+            << std::setprecision(3) << estimate.entropy << " bits/byte)"
+            << (estimate.incompressible ? " [incompressible]" : "") << "\n";
+    }
+    out << std::setprecision(6);
+    target << out.str();
+    target << "Analysis completed!" << std::endl;
+    target << "Files analyzed: " << estimates.size() << " (" << incompressibleCount
+           << " incompressible)" << std::endl;
+    target << "Original size: " << stats_.originalSize << " bytes" << std::endl;
+    target << "Estimated compressed size: " << stats_.compressedSize << " bytes" << std::endl;
+    target << "Estimated compression ratio: " << stats_.compressionRatio << "%" << std::endl;
+    target << "Estimated compression time: " << estimatedTime << " seconds" << std::endl;
+    target << "Analysis time: " << stats_.compressionTime << " seconds" << std::endl;
+}
 
-    std::filesystem::path relative = std::filesystem::relative(full, base);
-    return relative.string();
-}
\ No newline at end of file
+// 获取统计信息
+HuffmanCompressor::CompressionStats HuffmanCompressor::getCompressionStats() const {
+    return stats_;
+}
+
+// 各级别的压缩参数
+HuffmanCompressor::CompressionOptions HuffmanCompressor::CompressionOptions::preset(Level level) {
+    CompressionOptions options;
+    options.singlePass = false;
+    options.sampleInterval = 1;
+    options.blockSize = DEFAULT_BLOCK_SIZE;
+    options.maxCodeLength = 0;
+    options.solid = false;
+    options.reuseTables = true;
+    options.adaptiveSplit = false;
+    options.minBlockSize = MIN_BLOCK_SIZE;
+    options.pairAlphabet = false;
+    options.deduplicate = true;
+
+    switch (level) {
+    case Level::FAST:
+        // 只读一遍、统计 1/8 的字节；1 MiB 的块留在缓存中，11 位码长上限让解码表一次命中
+        options.singlePass = true;
+        options.sampleInterval = 8;
+        options.blockSize = 1 << 20;
+        options.maxCodeLength = 11;
+        options.solid = true;
+        break;
+    case Level::DEFAULT:
+        break;
+    case Level::MAX:
+        // 在统计特征变化处切分，块长 64 KiB 到 1 MiB，每块按完整统计建表，并尝试字节对字母表
+        options.singlePass = true;
+        options.blockSize = 1 << 20;
+        options.adaptiveSplit = true;
+        options.pairAlphabet = true;
+        options.solid = true;
+        break;
+    }
+    return options;
+}
+
+// 设置压缩参数
+void HuffmanCompressor::setOptions(const CompressionOptions& options) {
+    if (options.blockSize < MIN_BLOCK_SIZE || options.blockSize > MAX_BLOCK_SIZE) {
+        throw std::invalid_argument("Block size must be between 64 KiB and 64 MiB");
+    }
+    if (options.maxCodeLength != 0 &&
+        (options.maxCodeLength < MIN_CODE_LENGTH_LIMIT || options.maxCodeLength > MAX_CODE_LENGTH_LIMIT)) {
+        throw std::invalid_argument("Maximum code length must be 0 or between " +
+                                    std::to_string(MIN_CODE_LENGTH_LIMIT) + " and " +
+                                    std::to_string(MAX_CODE_LENGTH_LIMIT));
+    }
+    if (options.adaptiveSplit &&
+        (options.minBlockSize < MIN_SPLIT_SIZE || options.minBlockSize > options.blockSize)) {
+        throw std::invalid_argument("Minimum block size must be between 16 KiB and the block size");
+    }
+    options_ = options;
+    options_.sampleInterval = std::max<size_t>(options.sampleInterval, 1);
+}
+
+const HuffmanCompressor::CompressionOptions& HuffmanCompressor::getOptions() const {
+    return options_;
+}
+
+// 设置统计信息输出格式
+void HuffmanCompressor::setStatsFormat(StatsFormat format) {
+    statsFormat_ = format;
+}
+
+void HuffmanCompressor::setStatsOutput(std::ostream* out) {
+    statsOutput_ = out;
+}
+
+// 设置固实模式
+void HuffmanCompressor::setSolidMode(bool solid) {
+    options_.solid = solid;
+}
+
+// 设置单遍模式
+void HuffmanCompressor::setSinglePass(bool enabled, size_t sampleInterval) {
+    options_.singlePass = enabled;
+    options_.sampleInterval = sampleInterval == 0 ? 1 : sampleInterval;
+}
+
+// 设置解压输出是否 fsync
+void HuffmanCompressor::setSyncOutput(bool enabled) {
+    syncOutput_ = enabled;
+}
+
+// 设置目录解压的工作线程数
+void HuffmanCompressor::setThreadCount(size_t threadCount) {
+    threadCount_ = threadCount;
+}
+
+// 设置流式压缩的刷新间隔
+void HuffmanCompressor::setFlushInterval(size_t bytes) {
+    flushInterval_ = bytes;
+}
+
+// 设置单文件归档记录的文件名
+void HuffmanCompressor::setMemberName(const std::string& name) {
+    memberName_ = name;
+}
+
+// 设置分卷输出
+void HuffmanCompressor::setVolumes(uint64_t volumeSize, const std::vector<std::string>& directories) {
+    if (volumeSize != 0 && volumeSize < VolumeSet::MIN_VOLUME_SIZE) {
+        throw std::invalid_argument("Volume size must be at least " +
+                                    std::to_string(VolumeSet::MIN_VOLUME_SIZE) + " bytes");
+    }
+    volumeSize_ = volumeSize;
+    volumeDirs_ = directories;
+}
+
+// 设置增量模式的基准归档
+void HuffmanCompressor::setIncrementalBase(const std::string& previousArchive) {
+    incrementalBase_ = previousArchive;
+}
+
+// 设置是否记录内容哈希
+void HuffmanCompressor::setContentHash(bool enabled) {
+    contentHash_ = enabled;
+}
+
+// 以 JSON 对象输出统计信息
+std::string HuffmanCompressor::CompressionStats::toJson() const {
+    std::ostringstream out;
+    out << std::setprecision(6) << std::fixed;
+    out << "{\"operation\":\"" << operation << "\""
+        << ",\"isa\":\"" << isa << "\""
+        << ",\"originalSize\":" << originalSize
+        << ",\"compressedSize\":" << compressedSize
+        << ",\"compressionRatio\":" << compressionRatio
+        << ",\"totalTime\":" << compressionTime
+        << ",\"phases\":{"
+        << "\"traversal\":" << phases.traversal
+        << ",\"hash\":" << phases.hash
+        << ",\"histogram\":" << phases.histogram
+        << ",\"treeBuild\":" << phases.treeBuild
+        << ",\"codeGeneration\":" << phases.codeGeneration
+        << ",\"encode\":" << phases.encode
+        << ",\"decode\":" << phases.decode
+        << ",\"ioWait\":" << phases.ioWait
+        << ",\"write\":" << phases.write
+        << "}"
+        << ",\"bytesProcessed\":" << bytesProcessed
+        << ",\"bytesRead\":" << bytesRead
+        << ",\"blocksProcessed\":" << blocksProcessed
+        << ",\"filesProcessed\":" << filesProcessed
+        << ",\"filesReused\":" << filesReused
+        << ",\"bytesCopied\":" << bytesCopied
+        << ",\"filesDeduplicated\":" << filesDeduplicated
+        << ",\"bytesDeduplicated\":" << bytesDeduplicated
+        << ",\"bytesSampled\":" << bytesSampled
+        << ",\"tableBytes\":" << tableBytes
+        << ",\"tablesReused\":" << tablesReused
+        << ",\"pairBlocks\":" << pairBlocks
+        << ",\"splitOffsets\":[";
+    for (size_t i = 0; i < splitOffsets.size(); ++i) {
+        out << (i == 0 ? "" : ",") << splitOffsets[i];
+    }
+    out << "]"
+        << ",\"payloadBits\":" << payloadBits
+        << ",\"bitsPerSymbol\":" << bitsPerSymbol
+        << ",\"threadBusyTime\":{";
+    bool first = true;
+    for (const auto& pair : threadBusyTime) {
+        out << (first ? "" : ",") << "\"" << pair.first << "\":" << pair.second;
+        first = false;
+    }
+    out << "}"
+        << ",\"peakRss\":" << peakRss
+        << "}";
+    return out.str();
+}
+
+// 计算字符频率
+std::unordered_map<char, size_t> HuffmanCompressor::calculateFrequency(const std::string& filePath) {
+    auto phaseStart = Clock::now();
+
+    // 先用定长数组计数，避免逐字节哈希
+    size_t counts[256] = {0};
+    const Kernels& kernels = CpuDispatch::getKernels();
+
+    BlockReader reader(filePath);
+    const uint8_t* data;
+    size_t size;
+    while (reader.next(data, size)) {
+        HUFFZIP_TRACE_SPAN("histogram");
+        kernels.histogram(data, size, counts);
+    }
+
+    std::unordered_map<char, size_t> frequencyMap = toFrequencyMap(counts);
+
+    stats_.phases.histogram += secondsSince(phaseStart) - reader.getWaitTime();
+    recordReader(reader);
+
+    return frequencyMap;
+}
+
+// 计算内存缓冲区的字符频率
+std::unordered_map<char, size_t> HuffmanCompressor::calculateFrequency(const std::vector<uint8_t>& data) {
+    return calculateFrequency(data.data(), data.size());
+}
+
+std::unordered_map<char, size_t> HuffmanCompressor::calculateFrequency(const uint8_t* data, size_t size) {
+    HUFFZIP_TRACE_SPAN("histogram");
+    auto phaseStart = Clock::now();
+
+    size_t counts[256] = {0};
+    CpuDispatch::getKernels().histogram(data, size, counts);
+
+    std::unordered_map<char, size_t> frequencyMap = toFrequencyMap(counts);
+    stats_.bytesSampled += size;
+    stats_.phases.histogram += secondsSince(phaseStart);
+    return frequencyMap;
+}
+
+// 采样估计内存缓冲区的字符频率：每 sampleInterval 个片段统计一个
+// 未采到的字节值计数为 1，保证块内任何字节都有编码
+std::unordered_map<char, size_t> HuffmanCompressor::estimateFrequency(const uint8_t* data, size_t size) {
+    HUFFZIP_TRACE_SPAN("histogram");
+    auto phaseStart = Clock::now();
+
+    size_t counts[256] = {0};
+    size_t stride = SAMPLE_CHUNK_SIZE * options_.sampleInterval;
+    size_t sampled = 0;
+    for (size_t start = 0; start < size; start += stride) {
+        size_t end = std::min(start + SAMPLE_CHUNK_SIZE, size);
+        for (size_t i = start; i < end; ++i) {
+            counts[data[i]]++;
+        }
+        sampled += end - start;
+    }
+
+    for (int i = 0; i < 256; ++i) {
+        counts[i] = counts[i] * options_.sampleInterval + 1;
+    }
+
+    std::unordered_map<char, size_t> frequencyMap = toFrequencyMap(counts);
+    stats_.bytesSampled += sampled;
+    stats_.phases.histogram += secondsSince(phaseStart);
+    return frequencyMap;
+}
+
+// 逐块编码文件内容并写入位流
+void HuffmanCompressor::encodeFile(const std::string& filePath, BitStream& bitStream) {
+    BlockReader reader(filePath);
+    const uint8_t* data;
+    size_t size;
+    while (reader.next(data, size)) {
+        encodeBuffer(data, size, bitStream);
+    }
+
+    recordReader(reader);
+}
+
+// 单遍编码：每个缓冲块只读一次，按块内频率建表后立即编码
+// 块格式：类型（1字节）+ 表大小（8字节）+ 编码表 + 原始长度（8字节）
+//       + 各路位流长度（每路8字节）+ 各路字节对齐的位流
+// 类型为 BLOCK_PREVIOUS_TABLE 时没有表大小和编码表，沿用上一块的单字节编码表
+// 第 i 个字节编码到第 i % STREAM_COUNT 路，各路互不依赖，编解码时可交错执行
+// 类型为 BLOCK_PAIR_TABLE 时编码表为字节对字母表，块均分为 STREAM_COUNT 段，第 k 段编码到第 k 路
+void HuffmanCompressor::encodeFileSinglePass(const std::string& filePath, BlockWriter& writer,
+                                             BitStream& bitStream) {
+    BlockReader reader(filePath, 0, options_.blockSize, 2);
+    const Kernels& kernels = CpuDispatch::getKernels();
+    std::vector<uint8_t> streamBuffers[Kernels::STREAM_COUNT];
+
+    // 两棵树轮换：trees[current] 是上一块使用的表，新表建在另一棵中，被采用后再切换
+    HuffmanTree trees[2];
+    int current = -1;
+    PairAlphabet pairAlphabet;
+
+    const uint8_t* chunk;
+    size_t chunkSize;
+    uint64_t offset = 0;
+    while (reader.next(chunk, chunkSize)) {
+        // 自适应分块把读到的缓冲块再切成若干块，每块独立建表
+        std::vector<size_t> bounds;
+        if (options_.adaptiveSplit) {
+            bounds = findSplitPoints(chunk, chunkSize);
+            for (size_t bound : bounds) {
+                stats_.splitOffsets.push_back(offset + bound);
+            }
+        }
+        bounds.push_back(chunkSize);
+        offset += chunkSize;
+
+        size_t blockStart = 0;
+        for (size_t blockEnd : bounds) {
+            const uint8_t* data = chunk + blockStart;
+            size_t size = blockEnd - blockStart;
+            blockStart = blockEnd;
+
+            auto frequencyMap = options_.sampleInterval > 1 ? estimateFrequency(data, size)
+                                                            : calculateFrequency(data, size);
+            size_t counts[256];
+            toCounts(frequencyMap, counts);
+
+            // 沿用上一块的表只多写 1 字节；新表至少要付出熵下界加上表本身的位数
+            // 沿用代价不超过这个下界时不必建新表，否则建表后按实际代价比较
+            bool reuse = false;
+            uint64_t reuseBits = 0;
+            if (options_.reuseTables && current >= 0) {
+                reuseBits = encodedBits(counts, trees[current].getCodeLengths());
+                double newTableBound = entropyBits(counts) + tableBits(frequencyMap.size());
+                reuse = reuseBits != UINT64_MAX && reuseBits + 8 <= newTableBound;
+            }
+
+            std::vector<uint8_t> treeData;
+            int next = current < 0 ? 0 : 1 - current;
+            uint64_t blockBits = reuseBits + 8;
+            if (!reuse) {
+                HuffmanTree& tree = trees[next];
+
+                auto phaseStart = Clock::now();
+                tree.buildTree(frequencyMap, options_.maxCodeLength);
+                stats_.phases.treeBuild += secondsSince(phaseStart);
+
+                phaseStart = Clock::now();
+                tree.generateCodes();
+                treeData = tree.serialize();
+                stats_.phases.codeGeneration += secondsSince(phaseStart);
+
+                uint64_t newBits = encodedBits(counts, tree.getCodeLengths()) + (9 + treeData.size()) * 8;
+                if (current >= 0 && options_.reuseTables && reuseBits != UINT64_MAX && reuseBits + 8 <= newBits) {
+                    reuse = true;
+                } else {
+                    blockBits = newBits;
+                }
+            }
+
+            // 字节对字母表的总代价（含编码表）更低时改用它；沿用只针对单字节编码表，不改变 current
+            bool pairs = false;
+            std::vector<uint8_t> pairData;
+            if (options_.pairAlphabet) {
+                auto phaseStart = Clock::now();
+                uint64_t pairBits = pairAlphabet.build(data, size);
+                if (pairAlphabet.getPairCount() > 0) {
+                    pairData = pairAlphabet.serialize();
+                    pairs = pairBits + (9 + pairData.size()) * 8 < blockBits;
+                }
+                stats_.phases.treeBuild += secondsSince(phaseStart);
+            }
+
+            if (pairs) {
+                writer.put(BLOCK_PAIR_TABLE);
+                writeLE(writer, pairData.size(), 8);
+                writer.write(pairData.data(), pairData.size());
+                stats_.tableBytes += pairData.size();
+                stats_.pairBlocks++;
+            } else if (reuse) {
+                writer.put(BLOCK_PREVIOUS_TABLE);
+                stats_.tablesReused++;
+            } else {
+                current = next;
+                writeBlockTable(writer, treeData);
+                stats_.tableBytes += treeData.size();
+            }
+            writeLE(writer, size, 8);
+
+            HUFFZIP_TRACE_SPAN("encode");
+            auto phaseStart = Clock::now();
+            const uint8_t* codeLengths = pairs ? pairAlphabet.getCodeLengths() : trees[current].getCodeLengths();
+            unsigned maxLength = pairs ? PairAlphabet::MAX_CODE_LENGTH
+                                       : *std::max_element(codeLengths, codeLengths + 256);
+            if (maxLength > BitStream::MAX_FAST_CODE_LENGTH) {
+                throw std::runtime_error("Huffman code too long for single-pass mode");
+            }
+
+            uint8_t* streams[Kernels::STREAM_COUNT];
+            size_t streamSizes[Kernels::STREAM_COUNT];
+            for (size_t k = 0; k < Kernels::STREAM_COUNT; ++k) {
+                streamBuffers[k].resize(streamCapacity(size, maxLength));
+                streams[k] = streamBuffers[k].data();
+            }
+            if (pairs) {
+                stats_.payloadBits += kernels.encodePairs(pairAlphabet.getPairSymbols(), pairAlphabet.getCodeBits(),
+                                                          codeLengths, data, size, streams, streamSizes);
+            } else {
+                stats_.payloadBits += kernels.encodeStreams(trees[current].getCodeBits(), codeLengths,
+                                                            data, size, streams, streamSizes);
+            }
+            stats_.bytesProcessed += size;
+            stats_.phases.encode += secondsSince(phaseStart);
+
+            for (size_t k = 0; k < Kernels::STREAM_COUNT; ++k) {
+                writeLE(writer, streamSizes[k], 8);
+            }
+            for (size_t k = 0; k < Kernels::STREAM_COUNT; ++k) {
+                writer.write(streams[k], streamSizes[k]);
+            }
+        }
+    }
+
+    // 各块直接写入写入器，位流中没有待写的位
+    (void)bitStream;
+    recordReader(reader);
+}
+
+// 自适应分块：在缓冲块内以 minBlockSize / SPLIT_WINDOWS 为窗口，比较当前块与其后一个最小块
+// 合并编码与分开编码的 0 阶熵，差值超过新表和块头的开销时在两者之间切分
+// 切分后每块至少 minBlockSize（缓冲块本身更短时除外），块仍然彼此独立
+std::vector<size_t> HuffmanCompressor::findSplitPoints(const uint8_t* data, size_t size) {
+    HUFFZIP_TRACE_SPAN("split");
+    std::vector<size_t> bounds;
+    size_t window = options_.minBlockSize / SPLIT_WINDOWS;
+    size_t windowCount = (size + window - 1) / window;
+    if (windowCount < 2 * SPLIT_WINDOWS) {
+        return bounds;
+    }
+
+    auto phaseStart = Clock::now();
+    const Kernels& kernels = CpuDispatch::getKernels();
+    std::vector<size_t> windowCounts(windowCount * 256, 0);
+    for (size_t w = 0; w < windowCount; ++w) {
+        size_t begin = w * window;
+        kernels.histogram(data + begin, std::min(window, size - begin), &windowCounts[w * 256]);
+    }
+
+    // left 为当前块 [segmentStart, pos) 的计数，right 为候选块 [pos, pos + SPLIT_WINDOWS) 的计数
+    size_t left[256] = {0};
+    size_t right[256] = {0};
+    size_t merged[256];
+    auto addWindow = [&](size_t counts[256], size_t w) {
+        for (int i = 0; i < 256; ++i) {
+            counts[i] += windowCounts[w * 256 + i];
+        }
+    };
+    auto removeWindow = [&](size_t counts[256], size_t w) {
+        for (int i = 0; i < 256; ++i) {
+            counts[i] -= windowCounts[w * 256 + i];
+        }
+    };
+
+    size_t pos = SPLIT_WINDOWS;
+    for (size_t w = 0; w < pos; ++w) {
+        addWindow(left, w);
+    }
+    for (size_t w = pos; w < pos + SPLIT_WINDOWS; ++w) {
+        addWindow(right, w);
+    }
+
+    while ((pos + SPLIT_WINDOWS) * window <= size) {
+        size_t symbols = 0;
+        for (int i = 0; i < 256; ++i) {
+            merged[i] = left[i] + right[i];
+            symbols += right[i] > 0 ? 1 : 0;
+        }
+        // 新块的开销：编码表、原始长度和各路位流长度
+        double overhead = tableBits(symbols) + (1 + Kernels::STREAM_COUNT) * 64;
+        double gain = entropyBits(merged) - entropyBits(left) - entropyBits(right);
+
+        if (gain > overhead) {
+            bounds.push_back(pos * window);
+            std::copy(right, right + 256, left);
+            pos += SPLIT_WINDOWS;
+            std::fill(right, right + 256, 0);
+            for (size_t w = pos; w < std::min(pos + SPLIT_WINDOWS, windowCount); ++w) {
+                addWindow(right, w);
+            }
+        } else {
+            addWindow(left, pos);
+            removeWindow(right, pos);
+            if (pos + SPLIT_WINDOWS < windowCount) {
+                addWindow(right, pos + SPLIT_WINDOWS);
+            }
+            pos++;
+        }
+    }
+
+    stats_.phases.histogram += secondsSince(phaseStart);
+    return bounds;
+}
+
+// 编码内存中的数据并写入位流
+void HuffmanCompressor::encodeBuffer(const uint8_t* data, size_t size, BitStream& bitStream) {
+    HUFFZIP_TRACE_SPAN("encode");
+    auto phaseStart = Clock::now();
+
+    // 码长都不超过 MAX_FAST_CODE_LENGTH 位时使用扁平编码表内核，否则逐位写入
+    const uint8_t* codeLengths = huffmanTree_.getCodeLengths();
+    unsigned maxLength = *std::max_element(codeLengths, codeLengths + 256);
+    if (maxLength <= BitStream::MAX_FAST_CODE_LENGTH) {
+        stats_.payloadBits += CpuDispatch::getKernels().encode(huffmanTree_.getCodeBits(), codeLengths,
+                                                               data, size, bitStream);
+    } else {
+        for (size_t i = 0; i < size; ++i) {
+            std::string code = huffmanTree_.encode(static_cast<char>(data[i]));
+            for (char bit : code) {
+                bitStream.writeBit(bit == '1');
+            }
+            stats_.payloadBits += code.size();
+        }
+    }
+
+    stats_.bytesProcessed += size;
+    stats_.phases.encode += secondsSince(phaseStart);
+}
+
+// 按编码表的最长码长选择查表位数：8/11/12 位，更长的编码查 12 位表后遍历剩余子树
+HuffmanCompressor::Decoder HuffmanCompressor::prepareDecoder(const HuffmanTree& tree) const {
+    unsigned maxLength = tree.getMaxCodeLength();
+    if (maxLength == 0) {
+        throw std::runtime_error("Invalid Huffman table");
+    }
+
+    Decoder decoder;
+    if (maxLength <= 8) {
+        decoder.tableBits = 8;
+    } else if (maxLength <= 11) {
+        decoder.tableBits = 11;
+    } else {
+        decoder.tableBits = 12;
+    }
+    decoder.longCodes = maxLength > decoder.tableBits;
+    decoder.table = tree.buildDecodeTable(decoder.tableBits, decoder.subtrees);
+    return decoder;
+}
+
+// 从位流解码 count 个字节写入输出文件
+void HuffmanCompressor::decodeFile(const Decoder& decoder, BitStream& bitStream, size_t count,
+                                   const std::string& outputPath) {
+    BlockWriter writer(outputPath);
+    writer.setSync(syncOutput_);
+    writer.preallocate(count);
+    decodeInto(decoder, bitStream, count, writer);
+    writer.finish();
+    recordWriter(writer);
+}
+
+// 从位流解码 count 个字节交给写入器
+void HuffmanCompressor::decodeInto(const Decoder& decoder, BitStream& bitStream, size_t count,
+                                   BlockWriter& writer) {
+    HUFFZIP_TRACE_SPAN("decode");
+    const Kernels& kernels = CpuDispatch::getKernels();
+    Kernels::DecodeKernel kernel;
+    if (decoder.longCodes) {
+        kernel = kernels.decode12Long;
+    } else if (decoder.tableBits == 8) {
+        kernel = kernels.decode8;
+    } else if (decoder.tableBits == 11) {
+        kernel = kernels.decode11;
+    } else {
+        kernel = kernels.decode12;
+    }
+    kernel(decoder.table.data(), decoder.subtrees.data(), bitStream, count, writer);
+}
+
+// 解码单遍模式的单文件：逐块读取编码表、原始长度和各路位流后交错解码
+void HuffmanCompressor::decodeBlockedFile(BitStream& bitStream, uint64_t originalSize,
+                                          const std::string& outputPath) {
+    BlockWriter writer(outputPath);
+    writer.setSync(syncOutput_);
+    writer.preallocate(originalSize);
+    const Kernels& kernels = CpuDispatch::getKernels();
+    HuffmanTree blockTree;
+    Decoder decoder;
+    bool haveDecoder = false;
+    PairAlphabet pairAlphabet;
+    std::vector<uint32_t> pairTable;
+    std::vector<uint8_t> tableData;
+    std::vector<uint8_t> streamData;
+    std::vector<uint8_t> output;
+    uint64_t decoded = 0;
+
+    while (decoded < originalSize) {
+        // 沿用上一块编码表的块既不解析编码表，也不重建解码表
+        // 字节对块不影响沿用关系，之后的块沿用的仍是最近一张单字节编码表
+        uint8_t blockType = bitStream.readByte();
+        if (blockType == BLOCK_OWN_TABLE) {
+            readOwnTable(bitStream, blockTree);
+            decoder = prepareDecoder(blockTree);
+            haveDecoder = true;
+        } else if (blockType == BLOCK_PAIR_TABLE) {
+            uint64_t tableSize = readLE(bitStream, 8);
+            if (tableSize > MAX_TABLE_SIZE) {
+                throw std::runtime_error("Invalid data block in compressed file");
+            }
+            tableData.resize(static_cast<size_t>(tableSize));
+            bitStream.readBytes(tableData.data(), tableData.size());
+            pairAlphabet.deserialize(tableData.data(), tableData.size());
+            pairTable = pairAlphabet.buildDecodeTable();
+        } else if (blockType != BLOCK_PREVIOUS_TABLE || !haveDecoder) {
+            throw std::runtime_error("Invalid data block in compressed file");
+        }
+
+        // 块长度和位流长度都有上限，损坏的数据不会导致超出一块的内存分配
+        uint64_t blockLength = readLE(bitStream, 8);
+        if (blockLength == 0 || blockLength > MAX_BLOCK_SIZE || blockLength > originalSize - decoded) {
+            throw std::runtime_error("Invalid data block in compressed file");
+        }
+
+        size_t streamSizes[Kernels::STREAM_COUNT];
+        size_t totalSize = 0;
+        for (size_t k = 0; k < Kernels::STREAM_COUNT; ++k) {
+            uint64_t streamSize = readLE(bitStream, 8);
+            if (streamSize > streamCapacity(static_cast<size_t>(blockLength), BitStream::MAX_FAST_CODE_LENGTH)) {
+                throw std::runtime_error("Invalid data block in compressed file");
+            }
+            streamSizes[k] = static_cast<size_t>(streamSize);
+            totalSize += streamSizes[k];
+        }
+        streamData.resize(totalSize);
+        bitStream.readBytes(streamData.data(), totalSize);
+
+        const uint8_t* streams[Kernels::STREAM_COUNT];
+        const uint8_t* cursor = streamData.data();
+        for (size_t k = 0; k < Kernels::STREAM_COUNT; ++k) {
+            streams[k] = cursor;
+            cursor += streamSizes[k];
+        }
+
+        output.resize(blockLength);
+        if (blockType == BLOCK_PAIR_TABLE) {
+            HUFFZIP_TRACE_SPAN("decode");
+            kernels.decodePairs(pairTable.data(), streams, streamSizes, blockLength, output.data());
+        } else {
+            Kernels::DecodeStreamsKernel kernel;
+            if (decoder.longCodes) {
+                kernel = kernels.decodeStreams12Long;
+            } else if (decoder.tableBits == 8) {
+                kernel = kernels.decodeStreams8;
+            } else if (decoder.tableBits == 11) {
+                kernel = kernels.decodeStreams11;
+            } else {
+                kernel = kernels.decodeStreams12;
+            }
+            HUFFZIP_TRACE_SPAN("decode");
+            kernel(decoder.table.data(), decoder.subtrees.data(), streams, streamSizes,
+                   blockLength, output.data());
+        }
+        writer.write(output.data(), blockLength);
+        decoded += blockLength;
+    }
+
+    writer.finish();
+    recordWriter(writer);
+}
+
+// 写入文件头（多字节字段为小端序）
+void HuffmanCompressor::writeHeader(BlockWriter& outFile, const std::string& inputPath,
+                                    uint64_t originalSize, uint64_t treeSize, uint64_t dataSize,
+                                    uint8_t archiveType) {
+    if (inputPath.size() > 65535) {
+        throw std::runtime_error("Path too long: " + inputPath);
+    }
+
+    // 魔数（4字节）+ 版本号（1字节）
+    writeLE(outFile, MAGIC_NUMBER, 4);
+    outFile.put(VERSION);
+
+    // 原始大小、树大小、数据大小（各8字节）
+    writeLE(outFile, originalSize, 8);
+    writeLE(outFile, treeSize, 8);
+    writeLE(outFile, dataSize, 8);
+
+    // 类型标志（1字节）
+    outFile.put(archiveType);
+
+    // 文件名长度（2字节）+ 文件名（变长）
+    writeLE(outFile, inputPath.size(), 2);
+    outFile.write(inputPath.data(), inputPath.size());
+
+    // 保留字段（2字节）
+    writeLE(outFile, 0, 2);
+}
+
+// 读取文件头
+// Source 为 std::ifstream 或 BitStream（流式输入），通过对应的 readLE 读取
+template <typename Source>
+void HuffmanCompressor::readHeader(Source& inFile, std::string& originalPath,
+                                   uint64_t& originalSize, uint64_t& treeSize, uint64_t& dataSize,
+                                   uint8_t& archiveType) {
+    // 读取魔数
+    if (readLE(inFile, 4) != MAGIC_NUMBER) {
+        throw std::runtime_error("Invalid magic number");
+    }
+
+    // 读取版本号
+    uint8_t version = static_cast<uint8_t>(readLE(inFile, 1));
+    if (version != VERSION) {
+        throw std::runtime_error("Unsupported version: " + std::to_string(version));
+    }
+
+    // 读取原始大小、树大小、数据大小
+    originalSize = readLE(inFile, 8);
+    treeSize = readLE(inFile, 8);
+    dataSize = readLE(inFile, 8);
+
+    // 读取类型标志
+    archiveType = static_cast<uint8_t>(readLE(inFile, 1));
+    if (archiveType > ARCHIVE_STREAM) {
+        throw std::runtime_error("Unknown archive type: " + std::to_string(archiveType));
+    }
+
+    // 读取文件名
+    size_t pathLength = static_cast<size_t>(readLE(inFile, 2));
+    originalPath.assign(pathLength, '\0');
+    for (size_t i = 0; i < pathLength; ++i) {
+        originalPath[i] = static_cast<char>(readLE(inFile, 1));
+    }
+
+    // 跳过保留字段
+    readLE(inFile, 2);
+}
+
+// 更新文件头中的原始总大小和数据大小（写入器完成之后调用）
+void HuffmanCompressor::patchHeader(const std::string& archiveFile, uint64_t originalSize,
+                                    uint64_t dataSize) {
+    std::fstream headerFile(archiveFile, std::ios::binary | std::ios::in | std::ios::out);
+    uint8_t buffer[8];
+
+    storeLE(buffer, originalSize, 8);
+    headerFile.seekp(HEADER_ORIGINAL_SIZE_OFFSET);
+    headerFile.write(reinterpret_cast<const char*>(buffer), 8);
+
+    storeLE(buffer, dataSize, 8);
+    headerFile.seekp(HEADER_DATA_SIZE_OFFSET);
+    headerFile.write(reinterpret_cast<const char*>(buffer), 8);
+
+    headerFile.close();
+    if (!headerFile) {
+        throw std::runtime_error("Failed to update archive header: " + archiveFile);
+    }
+}
+
+// 打开归档写入器；分卷时先删除同名的单文件归档，否则解压时会优先读取它
+std::unique_ptr<BlockWriter> HuffmanCompressor::openArchiveWriter(const std::string& outputFile) {
+    if (volumeSize_ == 0) {
+        return std::unique_ptr<BlockWriter>(new BlockWriter(outputFile));
+    }
+    if (std::filesystem::is_regular_file(outputFile)) {
+        std::filesystem::remove(outputFile);
+    }
+    return std::unique_ptr<BlockWriter>(new BlockWriter(outputFile, volumeDirs_, volumeSize_));
+}
+
+// 文件头所在的文件：分卷时为第一个卷
+std::string HuffmanCompressor::firstVolumeOf(const std::string& outputFile) const {
+    return volumeSize_ == 0 ? outputFile : VolumeSet::volumePath(outputFile, volumeDirs_, 1);
+}
+
+// 遍历目录：并行扫描，结果按相对路径排序
+std::vector<FileEntry> HuffmanCompressor::traverseDirectory(const std::string& dirPath) {
+    DirectoryScanner scanner;
+    return scanner.scan(dirPath);
+}
+
+// 非固实模式：每个非空文件一个数据块，使用共享编码表
+void HuffmanCompressor::writeSharedTableBlocks(const std::string& inputDir,
+                                               std::vector<FileEntry>& fileEntries,
+                                               BlockWriter& writer, BitStream& bitStream) {
+    std::vector<FileEntry*> files;
+    for (auto& entry : fileEntries) {
+        if (!entry.isDirectory() && entry.getFileSize() > 0) {
+            files.push_back(&entry);
+        }
+    }
+
+    std::unique_ptr<DuplicateFinder> finder;
+    if (options_.deduplicate) {
+        finder.reset(new DuplicateFinder(inputDir, files));
+    }
+    std::vector<std::pair<FileEntry*, const FileEntry*>> duplicates;
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        const FileEntry* original = finder ? finder->duplicateOf(i) : nullptr;
+        if (original) {
+            duplicates.emplace_back(files[i], original);
+            continue;
+        }
+
+        uint64_t blockOffset = writer.getPosition();
+        writer.put(BLOCK_SHARED_TABLE);
+
+        std::string fullPath = inputDir + "/" + files[i]->getRelativePath();
+        encodeFile(fullPath, bitStream);
+        bitStream.flush();
+
+        files[i]->setDataOffset(blockOffset);
+        files[i]->setCompressedSize(writer.getPosition() - blockOffset);
+    }
+
+    if (finder) {
+        resolveDuplicates(*finder, duplicates);
+    }
+}
+
+// 固实模式：小文件按扩展名和路径排序后拼接成共享数据块，每块使用独立编码表
+void HuffmanCompressor::writeSolidBlocks(const std::string& inputDir,
+                                         std::vector<FileEntry>& fileEntries,
+                                         BlockWriter& writer, BitStream& bitStream) {
+    // 同类文件相邻，数据块内的统计特征更集中
+    std::vector<FileEntry*> files;
+    for (auto& entry : fileEntries) {
+        if (!entry.isDirectory() && entry.getFileSize() > 0) {
+            files.push_back(&entry);
+        }
+    }
+    std::stable_sort(files.begin(), files.end(), [](const FileEntry* a, const FileEntry* b) {
+        std::string extA = std::filesystem::path(a->getRelativePath()).extension().string();
+        std::string extB = std::filesystem::path(b->getRelativePath()).extension().string();
+        if (extA != extB) {
+            return extA < extB;
+        }
+        return a->getRelativePath() < b->getRelativePath();
+    });
+
+    // 哈希按编码顺序进行；重复文件不放入数据块，写完后引用首次出现的文件的位置
+    std::unique_ptr<DuplicateFinder> finder;
+    if (options_.deduplicate) {
+        finder.reset(new DuplicateFinder(inputDir, files));
+    }
+    std::vector<std::pair<FileEntry*, const FileEntry*>> duplicates;
+    auto isDuplicate = [&](size_t index) {
+        const FileEntry* original = finder ? finder->duplicateOf(index) : nullptr;
+        if (original) {
+            duplicates.emplace_back(files[index], original);
+        }
+        return original != nullptr;
+    };
+
+    std::vector<uint8_t> blockData;
+    size_t i = 0;
+    while (i < files.size()) {
+        if (isDuplicate(i)) {
+            i++;
+            continue;
+        }
+        FileEntry* first = files[i];
+        std::string firstPath = inputDir + "/" + first->getRelativePath();
+
+        // 大文件单独成块，流式读取两遍，不整体载入内存
+        if (first->getFileSize() >= options_.blockSize) {
+            huffmanTree_.buildTree(calculateFrequency(firstPath), options_.maxCodeLength);
+            huffmanTree_.generateCodes();
+
+            uint64_t blockOffset = writer.getPosition();
+            writeBlockTable(writer, huffmanTree_.serialize());
+            encodeFile(firstPath, bitStream);
+            bitStream.flush();
+
+            first->setDataOffset(blockOffset);
+            first->setCompressedSize(writer.getPosition() - blockOffset);
+            i++;
+            continue;
+        }
+
+        // 收集小文件直到数据块写满，跳过其中的重复文件
+        blockData.clear();
+        std::vector<FileEntry*> members;
+        size_t end = i;
+        while (end < files.size()) {
+            if (end > i && isDuplicate(end)) {
+                end++;
+                continue;
+            }
+            if (files[end]->getFileSize() >= options_.blockSize ||
+                blockData.size() + files[end]->getFileSize() > options_.blockSize) {
+                break;
+            }
+            files[end]->setOffsetInBlock(blockData.size());
+            appendFileContents(inputDir + "/" + files[end]->getRelativePath(),
+                               files[end]->getFileSize(), blockData);
+            members.push_back(files[end]);
+            end++;
+        }
+        stats_.bytesRead += blockData.size();
+        stats_.blocksProcessed++;
+
+        // 为整个数据块构建编码表
+        auto frequencyMap = calculateFrequency(blockData);
+
+        auto phaseStart = Clock::now();
+        huffmanTree_.buildTree(frequencyMap, options_.maxCodeLength);
+        stats_.phases.treeBuild += secondsSince(phaseStart);
+
+        phaseStart = Clock::now();
+        huffmanTree_.generateCodes();
+        std::vector<uint8_t> treeData = huffmanTree_.serialize();
+        stats_.phases.codeGeneration += secondsSince(phaseStart);
+
+        uint64_t blockOffset = writer.getPosition();
+        writeBlockTable(writer, treeData);
+        encodeBuffer(blockData.data(), blockData.size(), bitStream);
+        bitStream.flush();
+
+        uint64_t blockSize = writer.getPosition() - blockOffset;
+        for (FileEntry* member : members) {
+            member->setDataOffset(blockOffset);
+            member->setCompressedSize(blockSize);
+        }
+        i = end;
+    }
+
+    if (finder) {
+        resolveDuplicates(*finder, duplicates);
+    }
+}
+
+// 写入自带编码表的数据块头：类型（1字节）+ 表大小（8字节）+ 编码表
+void HuffmanCompressor::writeBlockTable(BlockWriter& writer, const std::vector<uint8_t>& treeData) {
+    writer.put(BLOCK_OWN_TABLE);
+    writeLE(writer, treeData.size(), 8);
+    writer.write(treeData.data(), treeData.size());
+}
+
+// 重复文件的条目指向首次出现的文件所在的数据块和块内偏移，并累加哈希线程的统计
+void HuffmanCompressor::resolveDuplicates(DuplicateFinder& finder,
+                                          const std::vector<std::pair<FileEntry*, const FileEntry*>>& duplicates) {
+    finder.finish();
+    for (const auto& duplicate : duplicates) {
+        duplicate.first->setDataOffset(duplicate.second->getDataOffset());
+        duplicate.first->setCompressedSize(duplicate.second->getCompressedSize());
+        duplicate.first->setOffsetInBlock(duplicate.second->getOffsetInBlock());
+        stats_.filesDeduplicated++;
+        stats_.bytesDeduplicated += duplicate.first->getFileSize();
+    }
+    stats_.bytesRead += finder.getBytesRead();
+    stats_.phases.hash += finder.getBusyTime();
+    stats_.phases.ioWait += finder.getWaitTime();
+    stats_.threadBusyTime["dedup"] += finder.getBusyTime();
+}
+
+// 计算文件内容哈希
+void HuffmanCompressor::computeContentHashes(const std::string& baseDir,
+                                             std::vector<FileEntry>& fileEntries) {
+    auto phaseStart = Clock::now();
+    for (auto& entry : fileEntries) {
+        if (!entry.isDirectory()) {
+            entry.setContentHash(ContentHasher::hashFile(baseDir + "/" + entry.getRelativePath()));
+            stats_.bytesRead += entry.getFileSize();
+        }
+    }
+    stats_.phases.hash += secondsSince(phaseStart);
+}
+
+// 增量模式：与旧归档索引比较，找出成员全部未变化的旧数据块
+HuffmanCompressor::IncrementalPlan HuffmanCompressor::planIncremental(std::vector<FileEntry>& fileEntries) {
+    IncrementalPlan plan;
+    plan.reused.assign(fileEntries.size(), false);
+
+    // 旧数据块由内核从基准归档直接复制，基准须为单个文件
+    if (VolumeSet::isMultiVolume(incrementalBase_, volumeDirs_)) {
+        throw std::runtime_error("Incremental base must be a single-volume archive: " + incrementalBase_);
+    }
+
+    std::ifstream inFile(incrementalBase_, std::ios::binary);
+    if (!inFile) {
+        throw std::runtime_error("Failed to open incremental base archive: " + incrementalBase_);
+    }
+
+    std::string originalPath;
+    uint64_t originalSize, treeSize, dataSize;
+    uint8_t archiveType;
+    readHeader(inFile, originalPath, originalSize, treeSize, dataSize, archiveType);
+    if (archiveType != ARCHIVE_DIRECTORY) {
+        throw std::runtime_error("Incremental base is not a directory archive: " + incrementalBase_);
+    }
+    if (treeSize > MAX_TABLE_SIZE) {
+        throw std::runtime_error("Invalid Huffman table in archive: " + incrementalBase_);
+    }
+
+    plan.sharedTable.resize(treeSize);
+    inFile.read(reinterpret_cast<char*>(plan.sharedTable.data()), treeSize);
+
+    uint64_t indexOffset;
+    std::vector<FileEntry> previousEntries = readIndex(inFile, indexOffset);
+
+    // 旧文件按路径查找，并统计每个旧数据块的成员数
+    std::unordered_map<std::string, const FileEntry*> previousByPath;
+    std::map<uint64_t, size_t> previousMembers;
+    for (const auto& entry : previousEntries) {
+        if (!entry.isDirectory() && entry.getFileSize() > 0) {
+            previousByPath[entry.getRelativePath()] = &entry;
+            previousMembers[entry.getDataOffset()]++;
+        }
+    }
+
+    // 大小和修改时间一致（启用内容哈希时哈希也须一致）视为未变化
+    std::map<uint64_t, std::vector<std::pair<size_t, const FileEntry*>>> candidates;
+    for (size_t i = 0; i < fileEntries.size(); ++i) {
+        const FileEntry& entry = fileEntries[i];
+        if (entry.isDirectory() || entry.getFileSize() == 0) {
+            continue;
+        }
+
+        auto it = previousByPath.find(entry.getRelativePath());
+        if (it == previousByPath.end()) {
+            continue;
+        }
+
+        const FileEntry& previous = *it->second;
+        if (previous.getFileSize() != entry.getFileSize() ||
+            previous.getModifiedTime() != entry.getModifiedTime()) {
+            continue;
+        }
+        if (contentHash_ && (previous.getContentHash() == 0 ||
+                             previous.getContentHash() != entry.getContentHash())) {
+            continue;
+        }
+
+        candidates[previous.getDataOffset()].emplace_back(i, &previous);
+    }
+
+    // 只有旧数据块的所有成员都未变化时，整块才能原样复制
+    for (const auto& pair : candidates) {
+        if (pair.second.size() != previousMembers[pair.first]) {
+            continue;
+        }
+
+        ReusedBlock block;
+        block.offset = pair.first;
+        block.size = pair.second.front().second->getCompressedSize();
+        for (const auto& member : pair.second) {
+            FileEntry& entry = fileEntries[member.first];
+            entry.setOffsetInBlock(member.second->getOffsetInBlock());
+            entry.setContentHash(member.second->getContentHash());
+            plan.reused[member.first] = true;
+            block.members.push_back(member.first);
+        }
+        plan.blocks.push_back(block);
+    }
+
+    return plan;
+}
+
+// 把未变化的旧数据块原样复制到新归档：块类型之后的内容由内核在两个文件间直接复制
+void HuffmanCompressor::copyReusedBlocks(const IncrementalPlan& plan, std::vector<FileEntry>& fileEntries,
+                                         BlockWriter& writer) {
+    if (plan.blocks.empty()) {
+        return;
+    }
+
+    int source = open(incrementalBase_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (source < 0) {
+        throw std::runtime_error("Failed to open incremental base archive: " + incrementalBase_);
+    }
+    try {
+        for (const auto& block : plan.blocks) {
+            uint64_t blockOffset = writer.getPosition();
+
+            uint8_t blockType = 0;
+            if (pread(source, &blockType, 1, static_cast<off_t>(block.offset)) != 1) {
+                throw std::runtime_error("Unexpected end of file while copying archive data");
+            }
+
+            // 旧归档的共享编码表在新归档中不再适用，改为块内自带
+            if (blockType == BLOCK_SHARED_TABLE) {
+                if (plan.sharedTable.empty()) {
+                    throw std::runtime_error("Invalid data block in incremental base archive");
+                }
+                writeBlockTable(writer, plan.sharedTable);
+            } else {
+                writer.put(blockType);
+            }
+            writer.copyFrom(source, block.offset + 1, block.size - 1);
+
+            uint64_t blockSize = writer.getPosition() - blockOffset;
+            for (size_t index : block.members) {
+                fileEntries[index].setDataOffset(blockOffset);
+                fileEntries[index].setCompressedSize(blockSize);
+            }
+
+            stats_.filesReused += block.members.size();
+            stats_.bytesCopied += block.size;
+        }
+    } catch (...) {
+        close(source);
+        throw;
+    }
+    close(source);
+}
+
+// 读取数据块头：自带编码表时反序列化到 blockTree 并返回它，否则返回共享编码表
+const HuffmanTree* HuffmanCompressor::readBlockTable(BitStream& bitStream, HuffmanTree& blockTree) {
+    uint8_t blockType = bitStream.readByte();
+    if (blockType == BLOCK_OWN_TABLE) {
+        readOwnTable(bitStream, blockTree);
+        return &blockTree;
+    }
+
+    if (blockType != BLOCK_SHARED_TABLE || !huffmanTree_.getRoot()) {
+        throw std::runtime_error("Invalid data block in archive");
+    }
+    return &huffmanTree_;
+}
+
+// 读取块类型之后的表大小（8字节）和编码表
+void HuffmanCompressor::readOwnTable(BitStream& bitStream, HuffmanTree& blockTree) {
+    uint64_t tableSize = readLE(bitStream, 8);
+    if (tableSize > MAX_TABLE_SIZE) {
+        throw std::runtime_error("Invalid data block in archive");
+    }
+    std::vector<uint8_t> tableData(static_cast<size_t>(tableSize));
+    bitStream.readBytes(tableData.data(), tableData.size());
+    size_t offset = 0;
+    blockTree.deserialize(tableData, offset);
+}
+
+// 写入目录索引和归档尾部
+void HuffmanCompressor::writeIndex(BlockWriter& writer, const std::vector<FileEntry>& fileEntries) {
+    // 先序列化整个索引，分卷时据此让索引和尾部完整地落在最后一卷
+    std::vector<uint8_t> indexData(8);
+    storeLE(indexData.data(), fileEntries.size(), 8);
+    for (const auto& entry : fileEntries) {
+        auto entryData = entry.serialize();
+        indexData.insert(indexData.end(), entryData.begin(), entryData.end());
+    }
+    writer.keepTogether(indexData.size() + 12);
+
+    // 文件条目数量（8字节）+ 文件条目
+    uint64_t indexOffset = writer.getPosition();
+    writer.write(indexData.data(), indexData.size());
+
+    // 尾部：索引偏移（8字节）+ 索引魔数（4字节）
+    writeLE(writer, indexOffset, 8);
+    writeLE(writer, INDEX_MAGIC, 4);
+}
+
+// 读取归档末尾的目录索引
+std::vector<FileEntry> HuffmanCompressor::readIndex(std::istream& inFile, uint64_t& indexOffset) {
+    inFile.seekg(0, std::ios::end);
+    uint64_t archiveSize = static_cast<uint64_t>(inFile.tellg());
+    if (archiveSize < 12) {
+        throw std::runtime_error("Archive too small to contain an index");
+    }
+
+    inFile.seekg(static_cast<std::streamoff>(archiveSize - 12));
+    indexOffset = readLE(inFile, 8);
+    uint64_t magic = readLE(inFile, 4);
+    if (magic != INDEX_MAGIC || archiveSize < 20 || indexOffset > archiveSize - 20) {
+        throw std::runtime_error("Invalid archive index");
+    }
+
+    std::vector<uint8_t> indexData(static_cast<size_t>(archiveSize - 12 - indexOffset));
+    inFile.seekg(static_cast<std::streamoff>(indexOffset));
+    inFile.read(reinterpret_cast<char*>(indexData.data()), static_cast<std::streamsize>(indexData.size()));
+    if (!inFile) {
+        throw std::runtime_error("Unexpected end of file while reading archive index");
+    }
+
+    // 条目数不可能超过索引能容纳的最少条目数，避免按损坏的计数分配内存
+    uint64_t entryCount = loadLE(indexData.data(), 8);
+    if (entryCount > (indexData.size() - 8) / FileEntry::MIN_SERIALIZED_SIZE) {
+        throw std::runtime_error("Invalid archive index");
+    }
+
+    std::vector<FileEntry> fileEntries(static_cast<size_t>(entryCount));
+    size_t offset = 8;
+    for (auto& entry : fileEntries) {
+        entry.deserialize(indexData, offset);
+    }
+
+    return fileEntries;
+}
+
+// 解压目录归档：先一次建好目录结构，再由多个线程各自解码整个数据块
+void HuffmanCompressor::extractDirectory(const std::string& inputFile, const VolumeSet* volumes,
+                                         const std::vector<FileEntry>& fileEntries,
+                                         const std::string& outputDir) {
+    createSkeleton(fileEntries, outputDir);
+
+    std::vector<const FileEntry*> files;
+    for (const auto& entry : fileEntries) {
+        if (!entry.isDirectory()) {
+            files.push_back(&entry);
+        }
+    }
+
+    // 按数据块偏移和块内偏移排序，同一数据块的文件归入一个任务
+    std::stable_sort(files.begin(), files.end(), [](const FileEntry* a, const FileEntry* b) {
+        if (a->getDataOffset() != b->getDataOffset()) {
+            return a->getDataOffset() < b->getDataOffset();
+        }
+        return a->getOffsetInBlock() < b->getOffsetInBlock();
+    });
+
+    std::vector<ExtractJob> jobs;
+    for (const FileEntry* file : files) {
+        bool sameBlock = !jobs.empty() && file->getFileSize() > 0 &&
+                         jobs.back().files.front()->getFileSize() > 0 &&
+                         jobs.back().dataOffset == file->getDataOffset();
+        if (!sameBlock) {
+            jobs.push_back(ExtractJob{file->getDataOffset(), file->getCompressedSize(), {}});
+        }
+        jobs.back().files.push_back(file);
+    }
+
+    size_t threadCount = threadCount_;
+    if (threadCount == 0) {
+        threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), MAX_EXTRACT_THREADS);
+    }
+    threadCount = std::max<size_t>(1, std::min(threadCount, jobs.size()));
+
+    // 各线程用自己的归档句柄按原子计数领取任务；分卷归档的各卷由各线程以 pread 同时读取
+    SharedDecoder sharedDecoder;
+    std::mutex statsMutex;
+    std::atomic<size_t> nextJob(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+
+    auto worker = [&]() {
+        HUFFZIP_TRACE_THREAD("extract");
+        try {
+            std::unique_ptr<std::istream> archive;
+            if (volumes) {
+                archive.reset(new VolumeSet::Stream(*volumes));
+            } else {
+                archive.reset(new std::ifstream(inputFile, std::ios::binary));
+            }
+            if (!*archive) {
+                throw std::runtime_error("Failed to open input file: " + inputFile);
+            }
+            std::vector<uint8_t> buffer;
+            while (!failed) {
+                size_t index = nextJob++;
+                if (index >= jobs.size()) {
+                    break;
+                }
+                extractBlock(jobs[index], inputFile, volumes, *archive, buffer, sharedDecoder, outputDir,
+                             statsMutex);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            failed = true;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threadCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    restoreTimestamps(fileEntries, outputDir);
+}
+
+// 建立目录结构：收集所有目录和文件的上级目录，按路径排序后父目录总在子目录之前创建
+void HuffmanCompressor::createSkeleton(const std::vector<FileEntry>& fileEntries,
+                                       const std::string& outputDir) {
+    std::set<std::string> directories;
+    for (const auto& entry : fileEntries) {
+        const std::string& path = entry.getRelativePath();
+        size_t slash = path.rfind('/');
+        std::string dir = entry.isDirectory() ? path
+                                              : (slash == std::string::npos ? std::string() : path.substr(0, slash));
+        // 某个目录已收集时，它的上级目录也都已收集
+        while (!dir.empty() && directories.insert(dir).second) {
+            slash = dir.rfind('/');
+            dir = slash == std::string::npos ? std::string() : dir.substr(0, slash);
+        }
+    }
+
+    for (const auto& dir : directories) {
+        std::string fullPath = outputDir + "/" + dir;
+        if (mkdir(fullPath.c_str(), 0777) != 0 && errno != EEXIST) {
+            throw std::runtime_error("Failed to create directory: " + fullPath);
+        }
+    }
+}
+
+// 解码一个数据块中的全部文件；不超过 IN_MEMORY_BLOCK_LIMIT 的数据块整块读入内存
+void HuffmanCompressor::extractBlock(const ExtractJob& job, const std::string& inputFile,
+                                     const VolumeSet* volumes, std::istream& archive, std::vector<uint8_t>& buffer,
+                                     SharedDecoder& sharedDecoder, const std::string& outputDir,
+                                     std::mutex& statsMutex) {
+    // 空文件没有数据块
+    if (job.files.front()->getFileSize() == 0) {
+        BlockWriter writer(outputDir + "/" + job.files.front()->getRelativePath(), 1, 0);
+        writer.setSync(syncOutput_);
+        writer.finish();
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats_.filesProcessed++;
+        return;
+    }
+
+    std::unique_ptr<BlockReader> reader;
+    std::unique_ptr<BitStream> bitStream;
+    if (job.compressedSize <= IN_MEMORY_BLOCK_LIMIT) {
+        buffer.resize(job.compressedSize);
+        archive.seekg(static_cast<std::streamoff>(job.dataOffset));
+        archive.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        if (!archive) {
+            throw std::runtime_error("Unexpected end of file while reading archive");
+        }
+        bitStream.reset(new BitStream(buffer.data(), buffer.size()));
+    } else {
+        reader.reset(volumes ? new BlockReader(*volumes, job.dataOffset)
+                             : new BlockReader(inputFile, job.dataOffset));
+        bitStream.reset(new BitStream(*reader));
+    }
+
+    // 解析数据块头，共享编码表的解码器只准备一次
+    HuffmanTree blockTree;
+    const HuffmanTree* tree = readBlockTable(*bitStream, blockTree);
+    Decoder blockDecoder;
+    const Decoder* decoder = &blockDecoder;
+    if (tree == &huffmanTree_) {
+        std::call_once(sharedDecoder.once, [&] {
+            sharedDecoder.decoder.reset(new Decoder(prepareDecoder(huffmanTree_)));
+        });
+        decoder = sharedDecoder.decoder.get();
+    } else {
+        blockDecoder = prepareDecoder(blockTree);
+    }
+
+    // 小文件在当前线程同步写入，大文件使用写线程
+    uint64_t decoded = 0;
+    double writeTime = 0.0;
+    const FileEntry* previous = nullptr;
+    for (const FileEntry* entry : job.files) {
+        // 重复文件与上一个文件引用同一段数据，直接复制已解出的文件
+        size_t fileSize = entry->getFileSize();
+        bool duplicate = previous && entry->getOffsetInBlock() == previous->getOffsetInBlock() &&
+                         fileSize == previous->getFileSize();
+        if (!duplicate && entry->getOffsetInBlock() != decoded) {
+            throw std::runtime_error("Corrupted archive index: " + entry->getRelativePath());
+        }
+
+        bool small = fileSize <= BlockWriter::DEFAULT_BLOCK_SIZE;
+        BlockWriter writer(outputDir + "/" + entry->getRelativePath(),
+                           small ? fileSize : BlockWriter::DEFAULT_BLOCK_SIZE,
+                           small ? 0 : BlockWriter::DEFAULT_RING_SIZE);
+        writer.setSync(syncOutput_);
+        writer.preallocate(fileSize);
+
+        if (duplicate) {
+            std::string sourcePath = outputDir + "/" + previous->getRelativePath();
+            int source = open(sourcePath.c_str(), O_RDONLY | O_CLOEXEC);
+            if (source < 0) {
+                throw std::runtime_error("Failed to open extracted file: " + sourcePath);
+            }
+            try {
+                writer.copyFrom(source, 0, fileSize);
+                writer.finish();
+            } catch (...) {
+                close(source);
+                throw;
+            }
+            close(source);
+            writeTime += writer.getBusyTime();
+            continue;
+        }
+
+        decodeInto(*decoder, *bitStream, fileSize, writer);
+        writer.finish();
+
+        writeTime += writer.getBusyTime();
+        decoded += fileSize;
+        previous = entry;
+    }
+
+    bitStream.reset();
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats_.filesProcessed += job.files.size();
+    stats_.phases.write += writeTime;
+    stats_.threadBusyTime["writer"] += writeTime;
+    if (reader) {
+        stats_.bytesRead += reader->getBytesRead();
+        stats_.blocksProcessed += reader->getBlocksRead();
+    } else {
+        stats_.bytesRead += job.compressedSize;
+        stats_.blocksProcessed++;
+    }
+}
+
+// 统一恢复修改时间：先文件后目录，因为在目录中创建文件会改变目录的修改时间
+void HuffmanCompressor::restoreTimestamps(const std::vector<FileEntry>& fileEntries,
+                                          const std::string& outputDir) {
+    for (int pass = 0; pass < 2; ++pass) {
+        for (const auto& entry : fileEntries) {
+            if (entry.isDirectory() != (pass == 1) || entry.getModifiedTime() == 0) {
+                continue;
+            }
+
+            int64_t seconds = entry.getModifiedTime() / 1000000000LL;
+            int64_t nanoseconds = entry.getModifiedTime() % 1000000000LL;
+            if (nanoseconds < 0) {
+                seconds--;
+                nanoseconds += 1000000000LL;
+            }
+
+            struct timespec times[2];
+            times[0].tv_sec = 0;
+            times[0].tv_nsec = UTIME_OMIT;
+            times[1].tv_sec = static_cast<time_t>(seconds);
+            times[1].tv_nsec = static_cast<long>(nanoseconds);
+
+            // 恢复失败（如文件系统不支持）不影响解压结果
+            std::string path = outputDir + "/" + entry.getRelativePath();
+            (void)utimensat(AT_FDCWD, path.c_str(), times, 0);
+        }
+    }
+}
+
+// 创建目录
+void HuffmanCompressor::createDirectory(const std::string& dirPath) {
+    if (!std::filesystem::exists(dirPath)) {
+        std::filesystem::create_directories(dirPath);
+    }
+}
+
+// 重置统计信息
+void HuffmanCompressor::resetStats(const std::string& operation) {
+    stats_ = CompressionStats();
+    stats_.operation = operation;
+    stats_.isa = CpuDispatch::isaName(CpuDispatch::getActiveIsa());
+}
+
+// 累加读流水线的统计
+void HuffmanCompressor::recordReader(const BlockReader& reader) {
+    stats_.phases.ioWait += reader.getWaitTime();
+    stats_.threadBusyTime["reader"] += reader.getBusyTime();
+    stats_.bytesRead += reader.getBytesRead();
+    stats_.blocksProcessed += reader.getBlocksRead();
+}
+
+// 累加写流水线的统计
+void HuffmanCompressor::recordWriter(const BlockWriter& writer) {
+    stats_.phases.ioWait += writer.getWaitTime();
+    stats_.phases.write += writer.getBusyTime();
+    stats_.threadBusyTime["writer"] += writer.getBusyTime();
+}
+
+// 计算派生统计量
+void HuffmanCompressor::finalizeStats(double totalTime) {
+    stats_.compressionTime = totalTime;
+    stats_.compressionRatio = stats_.originalSize > 0
+        ? (static_cast<double>(stats_.compressedSize) / stats_.originalSize) * 100.0
+        : 0.0;
+    stats_.bitsPerSymbol = stats_.bytesProcessed > 0
+        ? static_cast<double>(stats_.payloadBits) / stats_.bytesProcessed
+        : 0.0;
+    stats_.threadBusyTime["main"] = totalTime - stats_.phases.ioWait;
+    stats_.peakRss = peakResidentSetSize();
+}
+
+// 输出统计信息
+void HuffmanCompressor::printStats(std::ostream& defaultOut) const {
+    std::ostream& out = statsOutput_ ? *statsOutput_ : defaultOut;
+    if (statsFormat_ == StatsFormat::JSON) {
+        out << stats_.toJson() << std::endl;
+        return;
+    }
+
+    if (stats_.operation.rfind("decompress", 0) == 0) {
+        out << "Decompression completed!" << std::endl;
+        out << "Decompressed size: " << stats_.originalSize << " bytes" << std::endl;
+        out << "Decompression time: " << stats_.compressionTime << " seconds" << std::endl;
+        return;
+    }
+
+    if (stats_.operation == "compress-dir") {
+        out << "Directory compression completed!" << std::endl;
+        out << "Files compressed: " << stats_.filesProcessed << std::endl;
+        if (stats_.filesReused > 0) {
+            out << "Files reused: " << stats_.filesReused << std::endl;
+        }
+        if (stats_.filesDeduplicated > 0) {
+            out << "Duplicate files: " << stats_.filesDeduplicated << " ("
+                << stats_.bytesDeduplicated << " bytes stored once)" << std::endl;
+        }
+    } else if (stats_.operation == "append") {
+        out << "Append completed!" << std::endl;
+        out << "Files appended: " << stats_.filesProcessed << std::endl;
+        if (stats_.filesDeduplicated > 0) {
+            out << "Duplicate files: " << stats_.filesDeduplicated << " ("
+                << stats_.bytesDeduplicated << " bytes stored once)" << std::endl;
+        }
+    } else {
+        out << "Compression completed!" << std::endl;
+        if (stats_.tableBytes > 0) {
+            out << "Table overhead: " << stats_.tableBytes << " bytes ("
+                << stats_.bytesSampled << " bytes sampled, "
+                << stats_.tablesReused << " tables reused)" << std::endl;
+        }
+        if (stats_.pairBlocks > 0) {
+            out << "Byte-pair blocks: " << stats_.pairBlocks << std::endl;
+        }
+        if (!stats_.splitOffsets.empty()) {
+            out << "Adaptive splits: " << stats_.splitOffsets.size() << std::endl;
+        }
+    }
+    out << "Original size: " << stats_.originalSize << " bytes" << std::endl;
+    out << "Compressed size: " << stats_.compressedSize << " bytes" << std::endl;
+    out << "Compression ratio: " << stats_.compressionRatio << "%" << std::endl;
+    out << "Compression time: " << stats_.compressionTime << " seconds" << std::endl;
+}
@@ -3,11 +3,15 @@
 //
 
 #include "../include/HuffmanTree.hpp"
+#include "../include/Tracer.hpp"
+#include <algorithm>
 #include <queue>
 #include <stdexcept>
 
 HuffmanTree::HuffmanTree()
-    : root_(nullptr) {
+    : root_(nullptr)
+    , codeBits_{}
+    , codeLengths_{} {
 }
 
 void HuffmanTree::buildTree(const std::unordered_map<char, size_t>& frequencyMap) {
@@ -23,6 +27,12 @@ void HuffmanTree::buildTree(const std::unordered_map<char, size_t>& frequencyMap
         pq.push(new HuffmanNode(pair.first, pair.second));
     }
 
+    // 只有一种字符时补一个频率为 0 的叶子，保证每个字符至少有 1 位编码
+    if (frequencyMap.size() == 1) {
+        char other = static_cast<char>(static_cast<uint8_t>(frequencyMap.begin()->first) + 1);
+        pq.push(new HuffmanNode(other, 0));
+    }
+
     while (pq.size() > 1) {
         HuffmanNode* left = pq.top();
         pq.pop();
@@ -41,12 +51,38 @@ void HuffmanTree::buildTree(const std::unordered_map<char, size_t>& frequencyMap
     root_.reset(pq.top());
 }
 
+void HuffmanTree::buildTree(const std::unordered_map<char, size_t>& frequencyMap, unsigned maxCodeLength) {
+    HUFFZIP_TRACE_SPAN("build");
+    buildTree(frequencyMap);
+    if (maxCodeLength == 0 || maxDepthHelper(root_.get()) <= maxCodeLength) {
+        return;
+    }
+
+    // 频率减半（不低于 1）会压平树的形状，稀有字符的编码随之变短
+    std::unordered_map<char, size_t> scaled = frequencyMap;
+    while (maxDepthHelper(root_.get()) > maxCodeLength) {
+        bool changed = false;
+        for (auto& pair : scaled) {
+            size_t halved = (pair.second + 1) / 2;
+            changed = changed || halved != pair.second;
+            pair.second = halved;
+        }
+        if (!changed) {
+            throw std::invalid_argument("Maximum code length too small for alphabet");
+        }
+        buildTree(scaled);
+    }
+}
+
 void HuffmanTree::generateCodes() {
+    HUFFZIP_TRACE_SPAN("codes");
     if (!root_) {
         throw std::runtime_error("Tree not build");
     }
 
     encodingTable_.clear();
+    std::fill(codeBits_, codeBits_ + 256, 0);
+    std::fill(codeLengths_, codeLengths_ + 256, 0);
     generateCodesHelper(root_.get(), "");
 }
 
@@ -57,6 +93,14 @@ void HuffmanTree::generateCodesHelper(HuffmanNode *node, std::string code) {
 
     if (node->isLeaf()) {
         encodingTable_[node->getCharacter()] = code;
+
+        uint8_t index = static_cast<uint8_t>(node->getCharacter());
+        uint64_t bits = 0;
+        for (char bit : code) {
+            bits = (bits << 1) | (bit == '1' ? 1 : 0);
+        }
+        codeBits_[index] = bits;
+        codeLengths_[index] = static_cast<uint8_t>(std::min<size_t>(code.size(), 255));
         return;
     }
 
@@ -131,9 +175,75 @@ std::string HuffmanTree::encode(char character) const {
     return it->second;
 }
 
+const uint64_t* HuffmanTree::getCodeBits() const {
+    return codeBits_;
+}
+
+const uint8_t* HuffmanTree::getCodeLengths() const {
+    return codeLengths_;
+}
+
+unsigned HuffmanTree::getMaxCodeLength() const {
+    if (!root_) {
+        throw std::runtime_error("Tree not build");
+    }
+    return maxDepthHelper(root_.get());
+}
+
+unsigned HuffmanTree::maxDepthHelper(const HuffmanNode* node) const {
+    if (!node || node->isLeaf()) {
+        return 0;
+    }
+    return 1 + std::max(maxDepthHelper(node->getLeft()), maxDepthHelper(node->getRight()));
+}
+
+std::vector<uint32_t> HuffmanTree::buildDecodeTable(unsigned tableBits,
+                                                    std::vector<const HuffmanNode*>& subtrees) const {
+    if (!root_) {
+        throw std::runtime_error("Tree not build");
+    }
+    if (tableBits == 0 || tableBits > 16) {
+        throw std::invalid_argument("Unsupported decode table size");
+    }
+
+    std::vector<uint32_t> table(static_cast<size_t>(1) << tableBits, 0);
+    subtrees.clear();
+    decodeTableHelper(root_.get(), 0, 0, tableBits, table, subtrees);
+    return table;
+}
+
+// 码长为 length 的编码占据以它为前缀的 2^(tableBits - length) 个表项
+void HuffmanTree::decodeTableHelper(const HuffmanNode* node, uint32_t code, unsigned length, unsigned tableBits,
+                                    std::vector<uint32_t>& table,
+                                    std::vector<const HuffmanNode*>& subtrees) const {
+    if (!node) {
+        return;
+    }
+
+    if (node->isLeaf()) {
+        uint32_t entry = (length << 16) | static_cast<uint8_t>(node->getCharacter());
+        size_t first = static_cast<size_t>(code) << (tableBits - length);
+        size_t count = static_cast<size_t>(1) << (tableBits - length);
+        std::fill(table.begin() + first, table.begin() + first + count, entry);
+        return;
+    }
+
+    // 更长的编码在表中只记录剩余子树
+    if (length == tableBits) {
+        table[code] = static_cast<uint32_t>(subtrees.size());
+        subtrees.push_back(node);
+        return;
+    }
+
+    decodeTableHelper(node->getLeft(), code << 1, length + 1, tableBits, table, subtrees);
+    decodeTableHelper(node->getRight(), (code << 1) | 1, length + 1, tableBits, table, subtrees);
+}
+
 void HuffmanTree::clear() {
     root_.reset();
     encodingTable_.clear();
+    std::fill(codeBits_, codeBits_ + 256, 0);
+    std::fill(codeLengths_, codeLengths_ + 256, 0);
 }
 
 HuffmanNode* HuffmanTree::getRoot() const {
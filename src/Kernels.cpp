@@ -0,0 +1,605 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/Kernels.hpp"
+#include "../include/BitStream.hpp"
+#include "../include/BlockWriter.hpp"
+#include "../include/HuffmanNode.hpp"
+#include <cstring>
+#include <stdexcept>
+
+// x86 上用 target 属性为同一份实现生成多个指令集版本，其他平台只有标量版本
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define HUFFZIP_X86_DISPATCH 1
+#define HUFFZIP_INLINE inline __attribute__((always_inline))
+#include <immintrin.h>
+#else
+#define HUFFZIP_X86_DISPATCH 0
+#define HUFFZIP_INLINE inline
+#endif
+
+const size_t Kernels::STREAM_COUNT;
+const uint16_t Kernels::NO_PAIR;
+
+namespace {
+
+// ---------- 频率统计 ----------
+
+// 四组计数交替累加，减少相邻相同字节造成的写后读依赖
+HUFFZIP_INLINE void histogramImpl(const uint8_t* data, size_t size, size_t counts[256]) {
+    size_t partial[4][256] = {};
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        partial[0][data[i]]++;
+        partial[1][data[i + 1]]++;
+        partial[2][data[i + 2]]++;
+        partial[3][data[i + 3]]++;
+    }
+    for (; i < size; ++i) {
+        partial[0][data[i]]++;
+    }
+    for (int b = 0; b < 256; ++b) {
+        counts[b] += partial[0][b] + partial[1][b] + partial[2][b] + partial[3][b];
+    }
+}
+
+// ---------- 内容哈希 ----------
+
+const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+
+HUFFZIP_INLINE uint64_t readLE64(const uint8_t* p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+HUFFZIP_INLINE uint64_t mixRound(uint64_t accumulator, uint64_t input) {
+    accumulator += input * PRIME64_2;
+    accumulator = (accumulator << 31) | (accumulator >> 33);
+    return accumulator * PRIME64_1;
+}
+
+HUFFZIP_INLINE void hashStripesImpl(uint64_t accumulators[4], const uint8_t* data, size_t stripes) {
+    uint64_t a0 = accumulators[0];
+    uint64_t a1 = accumulators[1];
+    uint64_t a2 = accumulators[2];
+    uint64_t a3 = accumulators[3];
+    for (size_t i = 0; i < stripes; ++i, data += 32) {
+        a0 = mixRound(a0, readLE64(data));
+        a1 = mixRound(a1, readLE64(data + 8));
+        a2 = mixRound(a2, readLE64(data + 16));
+        a3 = mixRound(a3, readLE64(data + 24));
+    }
+    accumulators[0] = a0;
+    accumulators[1] = a1;
+    accumulators[2] = a2;
+    accumulators[3] = a3;
+}
+
+// ---------- 编码 ----------
+
+HUFFZIP_INLINE uint64_t encodeImpl(const uint64_t* codeBits, const uint8_t* codeLengths,
+                                   const uint8_t* data, size_t size, BitStream& bitStream) {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < size; ++i) {
+        unsigned length = codeLengths[data[i]];
+        bitStream.writeBits(codeBits[data[i]], length);
+        bits += length;
+    }
+    return bits;
+}
+
+// ---------- 多路交错编码 ----------
+
+// 按大端序写入 8 字节
+HUFFZIP_INLINE void storeBE64(uint8_t* p, uint64_t value) {
+    for (int i = 7; i >= 0; --i) {
+        p[i] = static_cast<uint8_t>(value);
+        value >>= 8;
+    }
+}
+
+// 内存中的一路输出位流，缓冲区高位对齐
+struct StreamWriter {
+    uint8_t* ptr;
+    uint64_t buffer;
+    unsigned count;
+
+    HUFFZIP_INLINE void put(uint64_t code, unsigned length) {
+        if (count + length > 64) {
+            // 整 8 字节写出，只前进已满的字节数（需要 8 字节余量）
+            storeBE64(ptr, buffer);
+            unsigned bytes = count >> 3;
+            ptr += bytes;
+            buffer = bytes == 8 ? 0 : buffer << (bytes * 8);
+            count -= bytes * 8;
+        }
+        buffer |= code << (64 - count - length);
+        count += length;
+    }
+
+    HUFFZIP_INLINE void finish() {
+        while (count > 0) {
+            *ptr++ = static_cast<uint8_t>(buffer >> 56);
+            buffer <<= 8;
+            count = count > 8 ? count - 8 : 0;
+        }
+    }
+};
+
+// 从第 start 个字节起把剩余数据按路编码，最后各路按字节对齐
+HUFFZIP_INLINE uint64_t encodeStreamsTail(const uint64_t* codeBits, const uint8_t* codeLengths,
+                                          const uint8_t* data, size_t start, size_t size,
+                                          StreamWriter writers[Kernels::STREAM_COUNT],
+                                          uint8_t* const streams[Kernels::STREAM_COUNT],
+                                          size_t streamSizes[Kernels::STREAM_COUNT]) {
+    uint64_t bits = 0;
+    size_t i = start;
+    for (; i + Kernels::STREAM_COUNT <= size; i += Kernels::STREAM_COUNT) {
+        for (size_t k = 0; k < Kernels::STREAM_COUNT; ++k) {
+            unsigned length = codeLengths[data[i + k]];
+            writers[k].put(codeBits[data[i + k]], length);
+            bits += length;
+        }
+    }
+    for (size_t k = 0; i < size; ++i, ++k) {
+        unsigned length = codeLengths[data[i]];
+        writers[k].put(codeBits[data[i]], length);
+        bits += length;
+    }
+
+    for (size_t k = 0; k < Kernels::STREAM_COUNT; ++k) {
+        writers[k].finish();
+        streamSizes[k] = static_cast<size_t>(writers[k].ptr - streams[k]);
+    }
+    return bits;
+}
+
+// 标量版本：四个位缓冲区互不依赖，可以交错执行
+HUFFZIP_INLINE uint64_t encodeStreamsImpl(const uint64_t* codeBits, const uint8_t* codeLengths,
+                                          const uint8_t* data, size_t size,
+                                          uint8_t* const streams[Kernels::STREAM_COUNT],
+                                          size_t streamSizes[Kernels::STREAM_COUNT]) {
+    StreamWriter writers[Kernels::STREAM_COUNT];
+    for (size_t k = 0; k < Kernels::STREAM_COUNT; ++k) {
+        writers[k] = StreamWriter{streams[k], 0, 0};
+    }
+    return encodeStreamsTail(codeBits, codeLengths, data, 0, size, writers, streams, streamSizes);
+}
+
+// ---------- 字节对字母表编码 ----------
+
+// 每段从头贪心切分：当前字节与下一字节（同一段内）组成的字节对在表中时编码为一个符号
+HUFFZIP_INLINE uint64_t encodePairsImpl(const uint16_t* pairSymbols, const uint64_t* codeBits,
+                                        const uint8_t* codeLengths, const uint8_t* data, size_t size,
+                                        uint8_t* const streams[Kernels::STREAM_COUNT],
+                                        size_t streamSizes[Kernels::STREAM_COUNT]) {
+    uint64_t bits = 0;
+    for (size_t k = 0; k < Kernels::STREAM_COUNT; ++k) {
+        StreamWriter writer{streams[k], 0, 0};
+        size_t i = pairSegmentStart(size, k);
+        size_t end = pairSegmentStart(size, k + 1);
+        while (i < end) {
+            unsigned symbol = data[i];
+            if (i + 1 < end) {
+                uint16_t pair = pairSymbols[data[i] | (data[i + 1] << 8)];
+                if (pair != Kernels::NO_PAIR) {
+                    symbol = pair;
+                    i++;
+                }
+            }
+            i++;
+            unsigned length = codeLengths[symbol];
+            writer.put(codeBits[symbol], length);
+            bits += length;
+        }
+        writer.finish();
+        streamSizes[k] = static_cast<size_t>(writer.ptr - streams[k]);
+    }
+    return bits;
+}
+
+#if HUFFZIP_X86_DISPATCH
+// AVX2 版本：四路位缓冲区放在一个 256 位寄存器中，每次从编码表 gather 4 个编码
+// 每轮处理 8 个字节（每路 2 个），要求最长码长不超过 16 位，保证一轮后每路不超过 63 位
+// 然后每路满 32 位的写出 4 字节，更长的编码表回退到标量版本
+__attribute__((target("avx2"))) HUFFZIP_INLINE
+uint64_t encodeStreamsAvx2(const uint64_t* codeBits, const uint8_t* codeLengths,
+                           const uint8_t* data, size_t size,
+                           uint8_t* const streams[Kernels::STREAM_COUNT],
+                           size_t streamSizes[Kernels::STREAM_COUNT]) {
+    static_assert(Kernels::STREAM_COUNT == 4, "AVX2 encoder packs four streams per register");
+
+    unsigned maxLength = 0;
+    alignas(32) uint64_t packed[256];
+    for (int b = 0; b < 256; ++b) {
+        packed[b] = (codeBits[b] << 6) | codeLengths[b];
+        maxLength = codeLengths[b] > maxLength ? codeLengths[b] : maxLength;
+    }
+    if (maxLength > 16) {
+        return encodeStreamsImpl(codeBits, codeLengths, data, size, streams, streamSizes);
+    }
+
+    const long long* table = reinterpret_cast<const long long*>(packed);
+    const __m256i lengthMask = _mm256_set1_epi64x(63);
+    const __m256i sixtyFour = _mm256_set1_epi64x(64);
+    const __m256i thirtyOne = _mm256_set1_epi64x(31);
+    const __m256i thirtyTwo = _mm256_set1_epi64x(32);
+    __m256i buffer = _mm256_setzero_si256();
+    __m256i count = _mm256_setzero_si256();
+    __m256i bits = _mm256_setzero_si256();
+
+    uint8_t* ptr[4] = {streams[0], streams[1], streams[2], streams[3]};
+    alignas(32) uint64_t laneBuffer[4];
+    alignas(32) uint64_t laneFlush[4];
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint32_t first;
+        uint32_t second;
+        std::memcpy(&first, data + i, 4);
+        std::memcpy(&second, data + i + 4, 4);
+
+        // 第 1 个字节：每路一个编码
+        __m256i index = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(static_cast<int>(first)));
+        __m256i entry = _mm256_i64gather_epi64(table, index, 8);
+        __m256i length = _mm256_and_si256(entry, lengthMask);
+        __m256i code = _mm256_srli_epi64(entry, 6);
+        count = _mm256_add_epi64(count, length);
+        buffer = _mm256_or_si256(buffer, _mm256_sllv_epi64(code, _mm256_sub_epi64(sixtyFour, count)));
+        bits = _mm256_add_epi64(bits, length);
+
+        // 第 2 个字节
+        index = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(static_cast<int>(second)));
+        entry = _mm256_i64gather_epi64(table, index, 8);
+        length = _mm256_and_si256(entry, lengthMask);
+        code = _mm256_srli_epi64(entry, 6);
+        count = _mm256_add_epi64(count, length);
+        buffer = _mm256_or_si256(buffer, _mm256_sllv_epi64(code, _mm256_sub_epi64(sixtyFour, count)));
+        bits = _mm256_add_epi64(bits, length);
+
+        // 每路满 32 位时写出高 32 位；未满的路同样写入但不前进，之后会被覆盖
+        __m256i flush = _mm256_and_si256(_mm256_cmpgt_epi64(count, thirtyOne), thirtyTwo);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(laneBuffer), buffer);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(laneFlush), flush);
+        for (int k = 0; k < 4; ++k) {
+            uint32_t top = static_cast<uint32_t>(laneBuffer[k] >> 32);
+            ptr[k][0] = static_cast<uint8_t>(top >> 24);
+            ptr[k][1] = static_cast<uint8_t>(top >> 16);
+            ptr[k][2] = static_cast<uint8_t>(top >> 8);
+            ptr[k][3] = static_cast<uint8_t>(top);
+            ptr[k] += laneFlush[k] >> 3;
+        }
+        buffer = _mm256_sllv_epi64(buffer, flush);
+        count = _mm256_sub_epi64(count, flush);
+    }
+
+    // 剩余不足 8 个字节交给标量版本，接着各路当前的位缓冲区继续写
+    alignas(32) uint64_t laneCount[4];
+    alignas(32) uint64_t laneBits[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneBuffer), buffer);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneCount), count);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneBits), bits);
+
+    StreamWriter writers[Kernels::STREAM_COUNT];
+    uint64_t total = 0;
+    for (int k = 0; k < 4; ++k) {
+        writers[k] = StreamWriter{ptr[k], laneBuffer[k], static_cast<unsigned>(laneCount[k])};
+        total += laneBits[k];
+    }
+    return total + encodeStreamsTail(codeBits, codeLengths, data, i, size, writers, streams, streamSizes);
+}
+#endif
+
+// ---------- 解码 ----------
+
+// 内存中的一路输入位流，接口与 BitStream 的批量读取接口一致
+struct StreamReader {
+    const uint8_t* ptr;
+    const uint8_t* end;
+    uint64_t buffer;
+    unsigned count;
+
+    HUFFZIP_INLINE void refill() {
+        if (count > 56) {
+            return;
+        }
+        if (end - ptr >= 8) {
+            uint64_t value = 0;
+            for (int i = 0; i < 8; ++i) {
+                value = (value << 8) | ptr[i];
+            }
+            unsigned bytes = (64 - count) >> 3;
+            unsigned newCount = count + bytes * 8;
+            buffer |= (value >> count) & (~0ULL << (64 - newCount));
+            count = newCount;
+            ptr += bytes;
+            return;
+        }
+        while (count <= 56 && ptr < end) {
+            buffer |= static_cast<uint64_t>(*ptr++) << (56 - count);
+            count += 8;
+        }
+    }
+    HUFFZIP_INLINE uint64_t peekBits() const { return buffer; }
+    HUFFZIP_INLINE unsigned bitsAvailable() const { return count; }
+    HUFFZIP_INLINE void consumeBits(unsigned bits) {
+        buffer <<= bits;
+        count -= bits;
+    }
+};
+
+// 从子树起逐位遍历，解出一个长编码字节
+template <typename Reader>
+uint8_t decodeLongCode(const HuffmanNode* node, Reader& reader) {
+    while (!node->isLeaf()) {
+        if (reader.bitsAvailable() == 0) {
+            reader.refill();
+            if (reader.bitsAvailable() == 0) {
+                throw std::runtime_error("Unexpected end of file while decompressing");
+            }
+        }
+        node = (reader.peekBits() >> 63) ? node->getRight() : node->getLeft();
+        reader.consumeBits(1);
+    }
+    return static_cast<uint8_t>(node->getCharacter());
+}
+
+// 查一次表解出一个字节（调用前须保证位数足够或已检查过）
+template <unsigned TableBits, bool LongCodes, typename Reader>
+HUFFZIP_INLINE uint8_t decodeSymbol(const uint32_t* table, const HuffmanNode* const* subtrees,
+                                    Reader& reader) {
+    uint32_t entry = table[reader.peekBits() >> (64 - TableBits)];
+    if (LongCodes && (entry >> 16) == 0) {
+        reader.consumeBits(TableBits);
+        return decodeLongCode(subtrees[entry], reader);
+    }
+    reader.consumeBits(entry >> 16);
+    return static_cast<uint8_t>(entry);
+}
+
+// 数据末尾的逐个解码：检查剩余位数是否够一个完整编码
+template <unsigned TableBits, bool LongCodes, typename Reader>
+HUFFZIP_INLINE uint8_t decodeSymbolChecked(const uint32_t* table, const HuffmanNode* const* subtrees,
+                                           Reader& reader) {
+    reader.refill();
+    uint32_t entry = table[reader.peekBits() >> (64 - TableBits)];
+    unsigned length = entry >> 16;
+    if (length == 0) {
+        length = TableBits;
+    }
+    if (length > reader.bitsAvailable()) {
+        throw std::runtime_error("Unexpected end of file while decompressing");
+    }
+    return decodeSymbol<TableBits, LongCodes>(table, subtrees, reader);
+}
+
+// 查表解码：每次查表解出一个字节，移位量和掩码均为编译期常量
+// LongCodes 为 false 时所有编码都不超过 TableBits，每次装满位缓冲区后连续解码
+// MAX_FAST_CODE_LENGTH / TableBits 个字节，循环次数为常量，可完全展开，且没有长编码分支
+template <unsigned TableBits, bool LongCodes>
+HUFFZIP_INLINE void decodeImpl(const uint32_t* table, const HuffmanNode* const* subtrees,
+                               BitStream& bitStream, size_t count, BlockWriter& writer) {
+    constexpr unsigned symbolsPerRefill = LongCodes ? 1 : BitStream::MAX_FAST_CODE_LENGTH / TableBits;
+
+    while (count >= symbolsPerRefill) {
+        bitStream.refill();
+        if (bitStream.bitsAvailable() < symbolsPerRefill * TableBits) {
+            break;
+        }
+        for (unsigned k = 0; k < symbolsPerRefill; ++k) {
+            writer.put(decodeSymbol<TableBits, LongCodes>(table, subtrees, bitStream));
+        }
+        count -= symbolsPerRefill;
+    }
+
+    // 数据末尾剩余位可能不足一次完整查表，逐个检查
+    while (count > 0) {
+        writer.put(decodeSymbolChecked<TableBits, LongCodes>(table, subtrees, bitStream));
+        count--;
+    }
+}
+
+// 多路交错解码：各路位缓冲区互不依赖，每轮先装满各路，再轮流解码
+template <unsigned TableBits, bool LongCodes>
+HUFFZIP_INLINE void decodeStreamsImpl(const uint32_t* table, const HuffmanNode* const* subtrees,
+                                      const uint8_t* const streams[Kernels::STREAM_COUNT],
+                                      const size_t streamSizes[Kernels::STREAM_COUNT],
+                                      size_t count, uint8_t* output) {
+    constexpr size_t ways = Kernels::STREAM_COUNT;
+    constexpr unsigned symbolsPerRefill = LongCodes ? 1 : BitStream::MAX_FAST_CODE_LENGTH / TableBits;
+    constexpr size_t symbolsPerRound = symbolsPerRefill * ways;
+
+    StreamReader readers[ways];
+    for (size_t k = 0; k < ways; ++k) {
+        readers[k] = StreamReader{streams[k], streams[k] + streamSizes[k], 0, 0};
+    }
+
+    size_t i = 0;
+    while (i + symbolsPerRound <= count) {
+        bool enough = true;
+        for (size_t k = 0; k < ways; ++k) {
+            readers[k].refill();
+            enough = enough && readers[k].bitsAvailable() >= symbolsPerRefill * TableBits;
+        }
+        if (!enough) {
+            break;
+        }
+        for (unsigned r = 0; r < symbolsPerRefill; ++r) {
+            for (size_t k = 0; k < ways; ++k) {
+                output[i++] = decodeSymbol<TableBits, LongCodes>(table, subtrees, readers[k]);
+            }
+        }
+    }
+
+    // 第 i 个字节属于第 i % ways 路
+    for (; i < count; ++i) {
+        output[i] = decodeSymbolChecked<TableBits, LongCodes>(table, subtrees, readers[i % ways]);
+    }
+}
+
+
+// ---------- 字节对字母表解码 ----------
+
+const unsigned PAIR_TABLE_BITS = 12;
+
+// 解码表项：(码长 << 24) | (字节数 << 16) | (第二个字节 << 8) | 第一个字节
+// 每次查表都写出两个字节，只前进实际的字节数，多写的一个字节随后被覆盖
+HUFFZIP_INLINE void decodePairsImpl(const uint32_t* table,
+                                    const uint8_t* const streams[Kernels::STREAM_COUNT],
+                                    const size_t streamSizes[Kernels::STREAM_COUNT],
+                                    size_t count, uint8_t* output) {
+    constexpr size_t ways = Kernels::STREAM_COUNT;
+    constexpr unsigned symbolsPerRefill = BitStream::MAX_FAST_CODE_LENGTH / PAIR_TABLE_BITS;
+
+    StreamReader readers[ways];
+    uint8_t* out[ways];
+    uint8_t* end[ways];
+    for (size_t k = 0; k < ways; ++k) {
+        readers[k] = StreamReader{streams[k], streams[k] + streamSizes[k], 0, 0};
+        out[k] = output + pairSegmentStart(count, k);
+        end[k] = output + pairSegmentStart(count, k + 1);
+    }
+
+    // 各段输出长度相同但符号数不同，先解完的段退出，其余段继续交错解码
+    // 每轮每段最多写到当前位置之后 2 * symbolsPerRefill 个字节，不会越过段尾
+    while (true) {
+        bool ready[ways];
+        bool any = false;
+        for (size_t k = 0; k < ways; ++k) {
+            readers[k].refill();
+            ready[k] = readers[k].bitsAvailable() >= symbolsPerRefill * PAIR_TABLE_BITS &&
+                       static_cast<size_t>(end[k] - out[k]) >= 2 * symbolsPerRefill;
+            any = any || ready[k];
+        }
+        if (!any) {
+            break;
+        }
+        for (unsigned r = 0; r < symbolsPerRefill; ++r) {
+            for (size_t k = 0; k < ways; ++k) {
+                if (!ready[k]) {
+                    continue;
+                }
+                uint32_t entry = table[readers[k].peekBits() >> (64 - PAIR_TABLE_BITS)];
+                readers[k].consumeBits(entry >> 24);
+                out[k][0] = static_cast<uint8_t>(entry);
+                out[k][1] = static_cast<uint8_t>(entry >> 8);
+                out[k] += (entry >> 16) & 3;
+            }
+        }
+    }
+
+    // 段尾逐个检查剩余位数和剩余字节数；无效表项的字节数为 0
+    for (size_t k = 0; k < ways; ++k) {
+        while (out[k] < end[k]) {
+            readers[k].refill();
+            uint32_t entry = table[readers[k].peekBits() >> (64 - PAIR_TABLE_BITS)];
+            unsigned length = entry >> 24;
+            size_t bytes = (entry >> 16) & 3;
+            if (length > readers[k].bitsAvailable() || bytes == 0 ||
+                bytes > static_cast<size_t>(end[k] - out[k])) {
+                throw std::runtime_error("Unexpected end of file while decompressing");
+            }
+            readers[k].consumeBits(length);
+            out[k][0] = static_cast<uint8_t>(entry);
+            if (bytes == 2) {
+                out[k][1] = static_cast<uint8_t>(entry >> 8);
+            }
+            out[k] += bytes;
+        }
+    }
+}
+
+}
+
+// 为一个指令集生成整组内核及其函数表，TARGET 为空时按编译器默认目标编译
+// ENCODE_STREAMS 为该指令集使用的多路编码实现
+#define HUFFZIP_DEFINE_KERNELS(NAME, TARGET, ENCODE_STREAMS)                                          \
+namespace {                                                                                           \
+TARGET void histogram_##NAME(const uint8_t* data, size_t size, size_t counts[256]) {                 \
+    histogramImpl(data, size, counts);                                                                \
+}                                                                                                     \
+TARGET void hashStripes_##NAME(uint64_t accumulators[4], const uint8_t* data, size_t stripes) {       \
+    hashStripesImpl(accumulators, data, stripes);                                                     \
+}                                                                                                     \
+TARGET uint64_t encode_##NAME(const uint64_t* codeBits, const uint8_t* codeLengths,                   \
+                              const uint8_t* data, size_t size, BitStream& bitStream) {               \
+    return encodeImpl(codeBits, codeLengths, data, size, bitStream);                                  \
+}                                                                                                     \
+TARGET uint64_t encodeStreams_##NAME(const uint64_t* codeBits, const uint8_t* codeLengths,            \
+                                     const uint8_t* data, size_t size,                                \
+                                     uint8_t* const streams[Kernels::STREAM_COUNT],                   \
+                                     size_t streamSizes[Kernels::STREAM_COUNT]) {                     \
+    return ENCODE_STREAMS(codeBits, codeLengths, data, size, streams, streamSizes);                   \
+}                                                                                                     \
+TARGET uint64_t encodePairs_##NAME(const uint16_t* pairSymbols, const uint64_t* codeBits,             \
+                                   const uint8_t* codeLengths, const uint8_t* data, size_t size,      \
+                                   uint8_t* const streams[Kernels::STREAM_COUNT],                     \
+                                   size_t streamSizes[Kernels::STREAM_COUNT]) {                       \
+    return encodePairsImpl(pairSymbols, codeBits, codeLengths, data, size, streams, streamSizes);     \
+}                                                                                                     \
+TARGET void decodePairs_##NAME(const uint32_t* table,                                                 \
+                               const uint8_t* const streams[Kernels::STREAM_COUNT],                   \
+                               const size_t streamSizes[Kernels::STREAM_COUNT],                       \
+                               size_t count, uint8_t* output) {                                       \
+    decodePairsImpl(table, streams, streamSizes, count, output);                                      \
+}                                                                                                     \
+TARGET void decode8_##NAME(const uint32_t* table, const HuffmanNode* const* subtrees,                 \
+                           BitStream& bitStream, size_t count, BlockWriter& writer) {                 \
+    decodeImpl<8, false>(table, subtrees, bitStream, count, writer);                                  \
+}                                                                                                     \
+TARGET void decode11_##NAME(const uint32_t* table, const HuffmanNode* const* subtrees,                \
+                            BitStream& bitStream, size_t count, BlockWriter& writer) {                \
+    decodeImpl<11, false>(table, subtrees, bitStream, count, writer);                                 \
+}                                                                                                     \
+TARGET void decode12_##NAME(const uint32_t* table, const HuffmanNode* const* subtrees,                \
+                            BitStream& bitStream, size_t count, BlockWriter& writer) {                \
+    decodeImpl<12, false>(table, subtrees, bitStream, count, writer);                                 \
+}                                                                                                     \
+TARGET void decode12Long_##NAME(const uint32_t* table, const HuffmanNode* const* subtrees,            \
+                                BitStream& bitStream, size_t count, BlockWriter& writer) {            \
+    decodeImpl<12, true>(table, subtrees, bitStream, count, writer);                                  \
+}                                                                                                     \
+template <unsigned TableBits, bool LongCodes>                                                         \
+TARGET void decodeStreams_##NAME(const uint32_t* table, const HuffmanNode* const* subtrees,           \
+                                 const uint8_t* const streams[Kernels::STREAM_COUNT],                 \
+                                 const size_t streamSizes[Kernels::STREAM_COUNT],                     \
+                                 size_t count, uint8_t* output) {                                     \
+    decodeStreamsImpl<TableBits, LongCodes>(table, subtrees, streams, streamSizes, count, output);     \
+}                                                                                                     \
+const Kernels NAME##Table = {                                                                         \
+    histogram_##NAME, hashStripes_##NAME, encode_##NAME, encodeStreams_##NAME,                        \
+    encodePairs_##NAME, decodePairs_##NAME,                                                           \
+    decode8_##NAME, decode11_##NAME, decode12_##NAME, decode12Long_##NAME,                            \
+    decodeStreams_##NAME<8, false>, decodeStreams_##NAME<11, false>,                                  \
+    decodeStreams_##NAME<12, false>, decodeStreams_##NAME<12, true>                                   \
+};                                                                                                    \
+}                                                                                                     \
+const Kernels* NAME##Kernels() {                                                                      \
+    return &NAME##Table;                                                                              \
+}
+
+HUFFZIP_DEFINE_KERNELS(scalar, , encodeStreamsImpl)
+
+#if HUFFZIP_X86_DISPATCH
+HUFFZIP_DEFINE_KERNELS(sse42, __attribute__((target("sse4.2,popcnt"))), encodeStreamsImpl)
+HUFFZIP_DEFINE_KERNELS(avx2, __attribute__((target("avx2,bmi,bmi2,lzcnt,popcnt"))), encodeStreamsAvx2)
+HUFFZIP_DEFINE_KERNELS(avx512, __attribute__((target("avx512f,avx512bw,avx2,bmi,bmi2,lzcnt,popcnt"))),
+                       encodeStreamsAvx2)
+#else
+const Kernels* sse42Kernels() {
+    return nullptr;
+}
+
+const Kernels* avx2Kernels() {
+    return nullptr;
+}
+
+const Kernels* avx512Kernels() {
+    return nullptr;
+}
+#endif
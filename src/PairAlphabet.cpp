@@ -0,0 +1,318 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/PairAlphabet.hpp"
+#include "../include/ByteOrder.hpp"
+#include "../include/Kernels.hpp"
+#include "../include/Tracer.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+const unsigned PairAlphabet::MAX_CODE_LENGTH;
+const size_t PairAlphabet::MAX_PAIRS;
+const size_t PairAlphabet::MIN_PAIR_COUNT;
+
+namespace {
+
+// 每个字节对在编码表中大约占用的位数：字节对本身 16 位加码长 4 位
+const uint64_t PAIR_TABLE_COST = 20;
+
+// 判定两字节相关：出现次数至少为独立期望的 DEPENDENCE_FACTOR 倍，且超出期望 DEPENDENCE_SIGMA 个标准差
+// （按泊松分布近似）；后者排除 65536 个字节对中随机数据的偶然偏高
+const double DEPENDENCE_FACTOR = 1.5;
+const double DEPENDENCE_SIGMA = 6.0;
+
+// 按频率构建哈夫曼树，返回各符号的码长（频率为 0 的符号码长为 0）
+// 叶子按频率排序后，新建的内部节点频率单调不减，用两个队列即可每次取出最小的两个
+std::vector<uint8_t> huffmanLengths(const std::vector<size_t>& counts) {
+    std::vector<uint8_t> lengths(counts.size(), 0);
+    std::vector<size_t> symbols;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (counts[i] > 0) {
+            symbols.push_back(i);
+        }
+    }
+    if (symbols.size() == 1) {
+        lengths[symbols[0]] = 1;
+        return lengths;
+    }
+    if (symbols.empty()) {
+        return lengths;
+    }
+    std::sort(symbols.begin(), symbols.end(), [&](size_t a, size_t b) {
+        return counts[a] != counts[b] ? counts[a] < counts[b] : a < b;
+    });
+
+    size_t leafCount = symbols.size();
+    std::vector<size_t> weight(2 * leafCount - 1);
+    std::vector<size_t> parent(2 * leafCount - 1);
+    for (size_t i = 0; i < leafCount; ++i) {
+        weight[i] = counts[symbols[i]];
+    }
+
+    size_t nextLeaf = 0;
+    size_t nextInternal = leafCount;
+    auto takeSmallest = [&](size_t end) {
+        if (nextLeaf < leafCount && (nextInternal >= end || weight[nextLeaf] <= weight[nextInternal])) {
+            return nextLeaf++;
+        }
+        return nextInternal++;
+    };
+    for (size_t node = leafCount; node < 2 * leafCount - 1; ++node) {
+        size_t left = takeSmallest(node);
+        size_t right = takeSmallest(node);
+        weight[node] = weight[left] + weight[right];
+        parent[left] = node;
+        parent[right] = node;
+    }
+
+    // 父节点的下标总比子节点大，从根向下依次得到深度
+    std::vector<unsigned> depth(2 * leafCount - 1, 0);
+    for (size_t node = 2 * leafCount - 1; node-- > 0;) {
+        if (node != 2 * leafCount - 2) {
+            depth[node] = depth[parent[node]] + 1;
+        }
+    }
+    for (size_t i = 0; i < leafCount; ++i) {
+        lengths[symbols[i]] = static_cast<uint8_t>(std::min<unsigned>(depth[i], 255));
+    }
+    return lengths;
+}
+
+}
+
+PairAlphabet::PairAlphabet()
+    : pairSymbols_(1 << 16, Kernels::NO_PAIR) {
+    setPairs(std::vector<uint16_t>());
+}
+
+// 先按重叠计数选出候选字节对，贪心切分后建立编码；再去掉按实际码长省下的位数
+// 抵不上编码表开销的字节对，重新切分一次
+uint64_t PairAlphabet::build(const uint8_t* data, size_t size) {
+    HUFFZIP_TRACE_SPAN("pairs");
+    std::vector<uint32_t> pairCounts(1 << 16, 0);
+    for (size_t k = 0; k < Kernels::STREAM_COUNT; ++k) {
+        size_t end = pairSegmentStart(size, k + 1);
+        for (size_t i = pairSegmentStart(size, k); i + 1 < end; ++i) {
+            pairCounts[data[i] | (data[i + 1] << 8)]++;
+        }
+    }
+
+    // 至少要有一个字节对的出现次数明显高于两字节独立出现时的期望，否则合并几乎省不下位数；
+    // 随机数据在这里就会放弃，省去后面的切分和建表
+    uint64_t byteCounts[256] = {};
+    for (size_t i = 0; i < size; ++i) {
+        byteCounts[data[i]]++;
+    }
+    std::vector<uint16_t> candidates;
+    bool dependent = false;
+    for (size_t pair = 0; pair < pairCounts.size(); ++pair) {
+        if (pairCounts[pair] >= MIN_PAIR_COUNT) {
+            candidates.push_back(static_cast<uint16_t>(pair));
+            double expected = static_cast<double>(byteCounts[pair & 0xFF]) * byteCounts[pair >> 8] / size;
+            double excess = pairCounts[pair] - expected;
+            dependent = dependent || (pairCounts[pair] >= DEPENDENCE_FACTOR * expected
+                                      && excess * excess >= DEPENDENCE_SIGMA * DEPENDENCE_SIGMA * expected);
+        }
+    }
+    if (!dependent) {
+        candidates.clear();
+        setPairs(candidates);
+        return 0;
+    }
+    auto byCount = [&](uint16_t a, uint16_t b) {
+        return pairCounts[a] != pairCounts[b] ? pairCounts[a] > pairCounts[b] : a < b;
+    };
+    if (candidates.size() > MAX_PAIRS) {
+        std::partial_sort(candidates.begin(), candidates.begin() + MAX_PAIRS, candidates.end(), byCount);
+        candidates.resize(MAX_PAIRS);
+    } else {
+        std::sort(candidates.begin(), candidates.end(), byCount);
+    }
+
+    std::vector<size_t> counts;
+    setPairs(candidates);
+    countSymbols(data, size, counts);
+    assignLengths(counts);
+
+    std::vector<uint16_t> kept;
+    for (size_t i = 0; i < pairs_.size(); ++i) {
+        size_t used = counts[256 + i];
+        unsigned first = codeLengths_[pairs_[i] & 0xFF];
+        unsigned second = codeLengths_[pairs_[i] >> 8];
+        unsigned separate = (first == 0 ? MAX_CODE_LENGTH : first) + (second == 0 ? MAX_CODE_LENGTH : second);
+        unsigned joined = codeLengths_[256 + i];
+        if (used > 0 && separate > joined && used * (separate - joined) > PAIR_TABLE_COST) {
+            kept.push_back(pairs_[i]);
+        }
+    }
+    if (kept.size() != pairs_.size()) {
+        setPairs(kept);
+        countSymbols(data, size, counts);
+        assignLengths(counts);
+    }
+
+    assignCodes();
+    return encodedBits(counts);
+}
+
+std::vector<uint8_t> PairAlphabet::serialize() const {
+    std::vector<uint8_t> data;
+    appendLE(data, pairs_.size(), 2);
+    for (uint16_t pair : pairs_) {
+        appendLE(data, pair, 2);
+    }
+    for (size_t i = 0; i < codeLengths_.size(); i += 2) {
+        uint8_t high = i + 1 < codeLengths_.size() ? codeLengths_[i + 1] : 0;
+        data.push_back(static_cast<uint8_t>(codeLengths_[i] | (high << 4)));
+    }
+    return data;
+}
+
+void PairAlphabet::deserialize(const uint8_t* data, size_t size) {
+    if (size < 2) {
+        throw std::runtime_error("Invalid pair table");
+    }
+    size_t pairCount = static_cast<size_t>(loadLE(data, 2));
+    size_t symbolCount = 256 + pairCount;
+    if (pairCount > MAX_PAIRS || size != 2 + pairCount * 2 + (symbolCount + 1) / 2) {
+        throw std::runtime_error("Invalid pair table");
+    }
+
+    std::vector<uint16_t> pairs(pairCount);
+    for (size_t i = 0; i < pairCount; ++i) {
+        pairs[i] = static_cast<uint16_t>(loadLE(data + 2 + i * 2, 2));
+    }
+    setPairs(pairs);
+    for (size_t i = 0; i < pairCount; ++i) {
+        if (pairSymbols_[pairs[i]] != 256 + i) {
+            throw std::runtime_error("Invalid pair table");
+        }
+    }
+
+    // 码长不超过上限，且满足 Kraft 不等式，否则范式编码会重叠
+    const uint8_t* packed = data + 2 + pairCount * 2;
+    uint64_t kraft = 0;
+    for (size_t i = 0; i < symbolCount; ++i) {
+        unsigned length = (packed[i / 2] >> ((i % 2) * 4)) & 0x0F;
+        if (length > MAX_CODE_LENGTH) {
+            throw std::runtime_error("Invalid pair table");
+        }
+        codeLengths_[i] = static_cast<uint8_t>(length);
+        kraft += length > 0 ? 1ULL << (MAX_CODE_LENGTH - length) : 0;
+    }
+    if (kraft == 0 || kraft > (1ULL << MAX_CODE_LENGTH)) {
+        throw std::runtime_error("Invalid pair table");
+    }
+    assignCodes();
+}
+
+std::vector<uint32_t> PairAlphabet::buildDecodeTable() const {
+    // 不对应任何编码的项：码长取满，字节数为 0，解码内核据此报错
+    std::vector<uint32_t> table(1 << MAX_CODE_LENGTH, MAX_CODE_LENGTH << 24);
+    for (size_t symbol = 0; symbol < codeLengths_.size(); ++symbol) {
+        unsigned length = codeLengths_[symbol];
+        if (length == 0) {
+            continue;
+        }
+        uint32_t entry = symbol < 256
+            ? (length << 24) | (1u << 16) | static_cast<uint32_t>(symbol)
+            : (length << 24) | (2u << 16) | pairs_[symbol - 256];
+        size_t first = static_cast<size_t>(codeBits_[symbol]) << (MAX_CODE_LENGTH - length);
+        std::fill(table.begin() + first, table.begin() + first + (size_t(1) << (MAX_CODE_LENGTH - length)), entry);
+    }
+    return table;
+}
+
+const uint16_t* PairAlphabet::getPairSymbols() const {
+    return pairSymbols_.data();
+}
+
+const uint64_t* PairAlphabet::getCodeBits() const {
+    return codeBits_.data();
+}
+
+const uint8_t* PairAlphabet::getCodeLengths() const {
+    return codeLengths_.data();
+}
+
+size_t PairAlphabet::getPairCount() const {
+    return pairs_.size();
+}
+
+// 只清除上一组字节对的映射，不必每次重置整张 64K 项的表
+void PairAlphabet::setPairs(const std::vector<uint16_t>& pairs) {
+    for (uint16_t pair : pairs_) {
+        pairSymbols_[pair] = Kernels::NO_PAIR;
+    }
+    pairs_ = pairs;
+    for (size_t i = 0; i < pairs_.size(); ++i) {
+        if (pairSymbols_[pairs_[i]] == Kernels::NO_PAIR) {
+            pairSymbols_[pairs_[i]] = static_cast<uint16_t>(256 + i);
+        }
+    }
+    codeBits_.assign(256 + pairs_.size(), 0);
+    codeLengths_.assign(256 + pairs_.size(), 0);
+}
+
+// 与编码内核相同的切分规则统计各符号的出现次数
+void PairAlphabet::countSymbols(const uint8_t* data, size_t size, std::vector<size_t>& counts) const {
+    counts.assign(256 + pairs_.size(), 0);
+    for (size_t k = 0; k < Kernels::STREAM_COUNT; ++k) {
+        size_t i = pairSegmentStart(size, k);
+        size_t end = pairSegmentStart(size, k + 1);
+        while (i < end) {
+            unsigned symbol = data[i];
+            if (i + 1 < end) {
+                uint16_t pair = pairSymbols_[data[i] | (data[i + 1] << 8)];
+                if (pair != Kernels::NO_PAIR) {
+                    symbol = pair;
+                    i++;
+                }
+            }
+            i++;
+            counts[symbol]++;
+        }
+    }
+}
+
+// 最长码长超过 MAX_CODE_LENGTH 时频率减半（不低于 1）后重建，与 HuffmanTree 的码长限制相同
+void PairAlphabet::assignLengths(std::vector<size_t> counts) {
+    while (true) {
+        std::vector<uint8_t> lengths = huffmanLengths(counts);
+        if (*std::max_element(lengths.begin(), lengths.end()) <= MAX_CODE_LENGTH) {
+            codeLengths_ = lengths;
+            return;
+        }
+        for (size_t& count : counts) {
+            count = count > 0 ? (count + 1) / 2 : 0;
+        }
+    }
+}
+
+// 范式编码：按 (码长, 符号) 的顺序依次分配，编码表只需保存码长
+void PairAlphabet::assignCodes() {
+    unsigned lengthCounts[MAX_CODE_LENGTH + 1] = {};
+    for (uint8_t length : codeLengths_) {
+        lengthCounts[length]++;
+    }
+    uint64_t nextCode[MAX_CODE_LENGTH + 1] = {};
+    uint64_t code = 0;
+    for (unsigned length = 1; length <= MAX_CODE_LENGTH; ++length) {
+        code = (code + (length > 1 ? lengthCounts[length - 1] : 0)) << 1;
+        nextCode[length] = code;
+    }
+    for (size_t symbol = 0; symbol < codeLengths_.size(); ++symbol) {
+        unsigned length = codeLengths_[symbol];
+        codeBits_[symbol] = length > 0 ? nextCode[length]++ : 0;
+    }
+}
+
+uint64_t PairAlphabet::encodedBits(const std::vector<size_t>& counts) const {
+    uint64_t bits = 0;
+    for (size_t symbol = 0; symbol < counts.size(); ++symbol) {
+        bits += static_cast<uint64_t>(counts[symbol]) * codeLengths_[symbol];
+    }
+    return bits;
+}
@@ -0,0 +1,129 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/Tracer.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+const size_t Tracer::MAX_EVENTS_PER_THREAD;
+std::atomic<bool> Tracer::active_(false);
+
+namespace {
+
+struct Event {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+// 一个线程的事件，线程结束后仍由注册表持有，退出时统一输出
+struct ThreadBuffer {
+    size_t id;
+    const char* name;
+    std::vector<Event> events;
+    uint64_t dropped;
+};
+
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+std::string outputPath;
+uint64_t origin = 0;
+
+thread_local ThreadBuffer* localBuffer = nullptr;
+
+// 当前线程的缓冲区，首次使用时登记
+ThreadBuffer& threadBuffer() {
+    if (!localBuffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.emplace_back(new ThreadBuffer{registry.size() + 1, nullptr, std::vector<Event>(), 0});
+        localBuffer = registry.back().get();
+        localBuffer->events.reserve(4096);
+    }
+    return *localBuffer;
+}
+
+}
+
+uint64_t Tracer::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Tracer::record(const char* name, uint64_t start, uint64_t end) {
+    ThreadBuffer& buffer = threadBuffer();
+    if (buffer.events.size() >= MAX_EVENTS_PER_THREAD) {
+        buffer.dropped++;
+        return;
+    }
+    buffer.events.push_back(Event{name, start, end});
+}
+
+void Tracer::setThreadName(const char* name) {
+    if (isActive() && !threadBuffer().name) {
+        threadBuffer().name = name;
+    }
+}
+
+#if defined(HUFFZIP_TRACE)
+
+void Tracer::start(const std::string& path) {
+    if (isActive()) {
+        return;
+    }
+    outputPath = path;
+    origin = now();
+    active_.store(true, std::memory_order_relaxed);
+    setThreadName("main");
+    std::atexit(&Tracer::writeTrace);
+}
+
+// 每段输出为一个完整事件（ph "X"），时间单位为微秒；线程名作为元数据事件输出
+void Tracer::writeTrace() {
+    active_.store(false, std::memory_order_relaxed);
+
+    std::ofstream out(outputPath);
+    if (!out) {
+        std::cerr << "Failed to write trace: " << outputPath << std::endl;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    uint64_t dropped = 0;
+    for (const auto& buffer : registry) {
+        out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+            << ",\"args\":{\"name\":\"" << (buffer->name ? buffer->name : "thread") << "-" << buffer->id << "\"}}";
+        first = false;
+        for (const Event& event : buffer->events) {
+            out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+                << ",\"ts\":" << (event.start - origin) / 1000.0
+                << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+        }
+        dropped += buffer->dropped;
+    }
+    out << "\n],\"otherData\":{\"droppedEvents\":" << dropped << "}}" << std::endl;
+    if (!out) {
+        std::cerr << "Failed to write trace: " << outputPath << std::endl;
+    }
+}
+
+#else
+
+void Tracer::start(const std::string&) {
+    throw std::runtime_error("Tracing is not available in this build (configure with -DHUFFZIP_TRACE=ON)");
+}
+
+void Tracer::writeTrace() {
+}
+
+#endif
@@ -0,0 +1,205 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/VolumeSet.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const size_t VolumeSet::MAX_VOLUMES;
+const uint64_t VolumeSet::MIN_VOLUME_SIZE;
+const size_t VolumeSet::READ_BUFFER_SIZE;
+
+namespace {
+
+const char VOLUME_SUFFIX_FIRST[] = ".001";
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}
+
+// 第 index 个卷的路径
+std::string VolumeSet::volumePath(const std::string& archivePath, const std::vector<std::string>& directories,
+                                  size_t index) {
+    char suffix[8];
+    std::snprintf(suffix, sizeof(suffix), ".%03zu", index);
+    if (directories.empty()) {
+        return archivePath + suffix;
+    }
+    std::string name = std::filesystem::path(archivePath).filename().string();
+    return directories[(index - 1) % directories.size()] + "/" + name + suffix;
+}
+
+bool VolumeSet::isMultiVolume(const std::string& archivePath, const std::vector<std::string>& directories) {
+    if (endsWith(archivePath, VOLUME_SUFFIX_FIRST)) {
+        return std::filesystem::exists(archivePath);
+    }
+    return !std::filesystem::exists(archivePath) && !findVolume(archivePath, directories, 1).empty();
+}
+
+// 构造函数：打开全部卷
+VolumeSet::VolumeSet(const std::string& archivePath, const std::vector<std::string>& directories) {
+    std::string basePath = archivePathOf(archivePath);
+    starts_.push_back(0);
+    try {
+        for (size_t index = 1; index <= MAX_VOLUMES; ++index) {
+            std::string path = findVolume(basePath, directories, index);
+            if (path.empty()) {
+                break;
+            }
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                throw std::runtime_error("Failed to open volume: " + path);
+            }
+            fds_.push_back(fd);
+            paths_.push_back(path);
+
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                throw std::runtime_error("Failed to read volume size: " + path);
+            }
+            starts_.push_back(starts_.back() + static_cast<uint64_t>(st.st_size));
+        }
+    } catch (...) {
+        for (int fd : fds_) {
+            close(fd);
+        }
+        throw;
+    }
+    if (fds_.empty()) {
+        throw std::runtime_error("No volumes found for archive: " + basePath);
+    }
+}
+
+// 析构函数
+VolumeSet::~VolumeSet() {
+    for (int fd : fds_) {
+        close(fd);
+    }
+}
+
+uint64_t VolumeSet::size() const {
+    return starts_.back();
+}
+
+size_t VolumeSet::count() const {
+    return fds_.size();
+}
+
+// 按归档偏移读取，跨卷时接着读下一卷
+size_t VolumeSet::read(uint64_t offset, void* data, size_t size) const {
+    uint8_t* out = static_cast<uint8_t*>(data);
+    size_t total = 0;
+    while (total < size && offset < this->size()) {
+        // 第一个起点大于 offset 的卷的前一卷即为 offset 所在的卷
+        size_t volume = static_cast<size_t>(std::upper_bound(starts_.begin(), starts_.end(), offset) -
+                                            starts_.begin()) - 1;
+        uint64_t inVolume = offset - starts_[volume];
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(size - total, starts_[volume + 1] - offset));
+        ssize_t count = pread(fds_[volume], out + total, chunk, static_cast<off_t>(inVolume));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            throw std::runtime_error("Failed to read volume: " + paths_[volume]);
+        }
+        if (count == 0) {
+            throw std::runtime_error("Volume changed while reading: " + paths_[volume]);
+        }
+        total += static_cast<size_t>(count);
+        offset += static_cast<uint64_t>(count);
+    }
+    return total;
+}
+
+std::string VolumeSet::archivePathOf(const std::string& path) {
+    return endsWith(path, VOLUME_SUFFIX_FIRST) ? path.substr(0, path.size() - 4) : path;
+}
+
+// 先在归档所在目录查找，再依次查找给定目录
+std::string VolumeSet::findVolume(const std::string& archivePath, const std::vector<std::string>& directories,
+                                  size_t index) {
+    std::string path = volumePath(archivePath, std::vector<std::string>(), index);
+    if (std::filesystem::exists(path)) {
+        return path;
+    }
+    for (const auto& directory : directories) {
+        path = volumePath(archivePath, std::vector<std::string>(1, directory), index);
+        if (std::filesystem::exists(path)) {
+            return path;
+        }
+    }
+    return std::string();
+}
+
+// 输入流
+VolumeSet::Stream::Stream(const VolumeSet& volumes)
+    : std::istream(nullptr)
+    , buffer_(volumes) {
+    rdbuf(&buffer_);
+}
+
+VolumeSet::Stream::Buffer::Buffer(const VolumeSet& volumes)
+    : volumes_(volumes)
+    , buffer_(READ_BUFFER_SIZE)
+    , bufferOffset_(0) {
+    setg(buffer_.data(), buffer_.data(), buffer_.data());
+}
+
+// 缓冲区读完后从下一个位置继续读取
+VolumeSet::Stream::Buffer::int_type VolumeSet::Stream::Buffer::underflow() {
+    bufferOffset_ += static_cast<uint64_t>(egptr() - eback());
+    size_t count = volumes_.read(bufferOffset_, buffer_.data(), buffer_.size());
+    setg(buffer_.data(), buffer_.data(), buffer_.data() + count);
+    return count == 0 ? traits_type::eof() : traits_type::to_int_type(buffer_[0]);
+}
+
+// 大块读取时先取走缓冲区中的剩余数据，其余直接从各卷读入目标，不经缓冲区复制
+std::streamsize VolumeSet::Stream::Buffer::xsgetn(char* data, std::streamsize count) {
+    std::streamsize buffered = std::min<std::streamsize>(count, egptr() - gptr());
+    std::memcpy(data, gptr(), static_cast<size_t>(buffered));
+    gbump(static_cast<int>(buffered));
+    if (buffered == count) {
+        return count;
+    }
+
+    uint64_t offset = bufferOffset_ + static_cast<uint64_t>(gptr() - eback());
+    size_t direct = volumes_.read(offset, data + buffered, static_cast<size_t>(count - buffered));
+    bufferOffset_ = offset + direct;
+    setg(buffer_.data(), buffer_.data(), buffer_.data());
+    return buffered + static_cast<std::streamsize>(direct);
+}
+
+VolumeSet::Stream::Buffer::pos_type VolumeSet::Stream::Buffer::seekoff(off_type offset,
+                                                                       std::ios_base::seekdir direction,
+                                                                       std::ios_base::openmode mode) {
+    uint64_t current = bufferOffset_ + static_cast<uint64_t>(gptr() - eback());
+    uint64_t base = direction == std::ios_base::beg ? 0
+                  : direction == std::ios_base::cur ? current
+                  : volumes_.size();
+    if (offset == 0 && direction == std::ios_base::cur) {
+        return pos_type(static_cast<off_type>(current));
+    }
+    return seekpos(pos_type(static_cast<off_type>(base) + offset), mode);
+}
+
+// 定位后清空缓冲区，下次读取时从新位置开始
+VolumeSet::Stream::Buffer::pos_type VolumeSet::Stream::Buffer::seekpos(pos_type position,
+                                                                       std::ios_base::openmode mode) {
+    off_type target = static_cast<off_type>(position);
+    if (!(mode & std::ios_base::in) || target < 0 || static_cast<uint64_t>(target) > volumes_.size()) {
+        return pos_type(off_type(-1));
+    }
+    bufferOffset_ = static_cast<uint64_t>(target);
+    setg(buffer_.data(), buffer_.data(), buffer_.data());
+    return position;
+}
@@ -2,34 +2,329 @@
 // Created by Musubi on 2026/1/18.
 //
 #include "../include/HuffmanCompressor.hpp"
+#include "../include/BatchRunner.hpp"
+#include "../include/CompressionServer.hpp"
+#include "../include/CpuDispatch.hpp"
+#include "../include/Tracer.hpp"
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 void printUsage(const char* programName) {
-    std::cout << "Usage: " << programName << " <command> <input> <output>" << std::endl;
+    std::cout << "Usage: " << programName << " [options] <command> <input> <output>" << std::endl;
+    std::cout << "       " << programName << " [options] append <archive> <paths...>" << std::endl;
+    std::cout << "       " << programName << " [options] analyze <path>" << std::endl;
+    std::cout << "       " << programName << " [options] serve <socket>" << std::endl;
+    std::cout << "       " << programName << " [options] batch <joblist>" << std::endl;
     std::cout << "Commands:" << std::endl;
     std::cout << "  compress-file   - Compress a single file" << std::endl;
     std::cout << "  compress-dir    - Compress a directory" << std::endl;
     std::cout << "  decompress      - Decompress a file" << std::endl;
+    std::cout << "  append          - Append files or directories to a directory archive" << std::endl;
+    std::cout << "  compress-stream - Adaptive Huffman, emits output at flush points (\"-\" = stdin/stdout)" << std::endl;
+    std::cout << "  decompress-stream" << std::endl;
+    std::cout << "                  - Decompress a stream archive to a single file (\"-\" = stdin/stdout)" << std::endl;
+    std::cout << "  analyze         - Estimate compressed size and time of a file or directory without writing" << std::endl;
+    std::cout << "  serve           - Handle requests on a Unix domain socket with resident worker threads" << std::endl;
+    std::cout << "  batch           - Run one \"<command> <input> <output>\" job per line (\"-\" = stdin), continue on errors" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --stats=text|json  - Statistics output format (default: text)" << std::endl;
+    std::cout << "  --level=fast|default|max" << std::endl;
+    std::cout << "                     - Compression preset; the options below override individual settings" << std::endl;
+    std::cout << "  --solid            - compress-dir: pack small files into shared blocks" << std::endl;
+    std::cout << "  --incremental <archive>" << std::endl;
+    std::cout << "                     - compress-dir: copy blocks of unchanged files from a previous archive" << std::endl;
+    std::cout << "  --no-dedup         - compress-dir/append: encode identical files separately instead of storing them once" << std::endl;
+    std::cout << "  --force-isa=NAME   - Use scalar|sse4.2|avx2|avx512 kernels instead of the detected best" << std::endl;
+    std::cout << "  --hash             - Record content hashes (incremental mode also compares them)" << std::endl;
+    std::cout << "  --single-pass      - compress-file: read input once, build a table per block" << std::endl;
+    std::cout << "  --sample=N         - Like --single-pass, estimate each table from 1/N of the block" << std::endl;
+    std::cout << "  --block-size=N     - Single-pass and solid block size, K/M suffixes allowed (64K to 64M)" << std::endl;
+    std::cout << "  --adaptive-split   - Single-pass: also end blocks early where the byte statistics change" << std::endl;
+    std::cout << "  --min-block-size=N - Smallest block adaptive splitting may produce (16K up to the block size)" << std::endl;
+    std::cout << "  --no-table-reuse   - Single-pass: always store a new table instead of repeating the previous one" << std::endl;
+    std::cout << "  --pairs            - Single-pass: also try a byte-pair alphabet per block and keep it when smaller" << std::endl;
+    std::cout << "  --max-code-length=N" << std::endl;
+    std::cout << "                     - Limit Huffman codes to N bits (8 to 57, 0 = unlimited)" << std::endl;
+    std::cout << "  --threads=N        - decompress/analyze/serve/batch: number of worker threads (default: CPU count, max 8)" << std::endl;
+    std::cout << "  --flush-interval=N - compress-stream: emit a flush point at least every N input bytes" << std::endl;
+    std::cout << "  --fsync            - decompress: fsync each extracted file before closing it (default: off)" << std::endl;
+    std::cout << "  --no-fsync         - decompress: do not fsync extracted files (the default)" << std::endl;
+    std::cout << "  --volume-size=N    - compress-file/compress-dir: split the archive into N-byte volumes <output>.001, .002, ..." << std::endl;
+    std::cout << "                       (K/M/G suffixes allowed, at least 64K); volumes are cut at fixed byte offsets," << std::endl;
+    std::cout << "                       so blocks may span volumes and every volume is needed to decompress" << std::endl;
+    std::cout << "  --volume-dir=DIR   - Place volumes round-robin in DIR (repeatable); decompress also looks for volumes there" << std::endl;
+    std::cout << "                       (volumes are written one after another, not concurrently)" << std::endl;
+    std::cout << "  --trace=FILE       - Write a Chrome trace-event JSON of the pipeline phases to FILE on exit" << std::endl;
     std::cout << std::endl;
     std::cout << "Examples:" << std::endl;
     std::cout << "  " << programName << " compress-file input.txt output.huff" << std::endl;
     std::cout << "  " << programName << " compress-dir mydir archive.huff" << std::endl;
     std::cout << "  " << programName << " decompress archive.huff outputdir" << std::endl;
+    std::cout << "  " << programName << " --stats=json compress-file input.txt output.huff" << std::endl;
+    std::cout << "  " << programName << " --solid compress-dir mydir archive.huff" << std::endl;
+    std::cout << "  " << programName << " append archive.huff new.log newdir" << std::endl;
+    std::cout << "  " << programName << " --incremental old.huff compress-dir mydir new.huff" << std::endl;
+    std::cout << "  " << programName << " --sample=16 compress-file export.csv export.huff" << std::endl;
+    std::cout << "  " << programName << " --level=fast compress-dir mydir archive.huff" << std::endl;
+    std::cout << "  " << programName << " analyze mydir" << std::endl;
+    std::cout << "  " << programName << " --level=fast serve /run/huffzip.sock" << std::endl;
+    std::cout << "  " << programName << " --threads=4 --stats=json batch jobs.txt" << std::endl;
+    std::cout << "  " << programName << " --volume-size=4G --volume-dir=/mnt/a --volume-dir=/mnt/b compress-dir mydir archive.huff" << std::endl;
+    std::cout << "  tail -f app.log | " << programName << " compress-stream - app.log.huff" << std::endl;
+}
+
+// 解析带可选 K/M/G 后缀的字节数
+bool parseSize(const std::string& text, size_t& value) {
+    size_t pos = 0;
+    unsigned long long number;
+    try {
+        number = std::stoull(text, &pos);
+    } catch (const std::exception&) {
+        return false;
+    }
+    std::string suffix = text.substr(pos);
+    if (suffix == "K" || suffix == "k") {
+        number <<= 10;
+    } else if (suffix == "M" || suffix == "m") {
+        number <<= 20;
+    } else if (suffix == "G" || suffix == "g") {
+        number <<= 30;
+    } else if (!suffix.empty()) {
+        return false;
+    }
+    value = static_cast<size_t>(number);
+    return true;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 4) {
+    // 分离选项与位置参数
+    std::vector<std::string> args;
+    HuffmanCompressor::StatsFormat statsFormat = HuffmanCompressor::StatsFormat::TEXT;
+    HuffmanCompressor::Level level = HuffmanCompressor::Level::DEFAULT;
+    bool solid = false;
+    bool hash = false;
+    bool singlePass = false;
+    bool noTableReuse = false;
+    bool pairAlphabet = false;
+    bool noDedup = false;
+    size_t sampleInterval = 0;
+    size_t blockSize = 0;
+    bool adaptiveSplit = false;
+    size_t minBlockSize = 0;
+    long long maxCodeLength = -1;
+    size_t threadCount = 0;
+    size_t flushInterval = 0;
+    bool syncOutput = false;
+    size_t volumeSize = 0;
+    std::vector<std::string> volumeDirs;
+    std::string incrementalBase;
+    std::string forcedIsa;
+    std::string tracePath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stats=json") {
+            statsFormat = HuffmanCompressor::StatsFormat::JSON;
+        } else if (arg == "--stats=text") {
+            statsFormat = HuffmanCompressor::StatsFormat::TEXT;
+        } else if (arg == "--level=fast") {
+            level = HuffmanCompressor::Level::FAST;
+        } else if (arg == "--level=default") {
+            level = HuffmanCompressor::Level::DEFAULT;
+        } else if (arg == "--level=max") {
+            level = HuffmanCompressor::Level::MAX;
+        } else if (arg.rfind("--block-size=", 0) == 0) {
+            if (!parseSize(arg.substr(std::string("--block-size=").size()), blockSize) || blockSize == 0) {
+                std::cerr << "Invalid block size: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg.rfind("--min-block-size=", 0) == 0) {
+            if (!parseSize(arg.substr(std::string("--min-block-size=").size()), minBlockSize) ||
+                minBlockSize == 0) {
+                std::cerr << "Invalid minimum block size: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            adaptiveSplit = true;
+        } else if (arg == "--adaptive-split") {
+            adaptiveSplit = true;
+        } else if (arg.rfind("--max-code-length=", 0) == 0) {
+            try {
+                maxCodeLength = std::stoll(arg.substr(std::string("--max-code-length=").size()));
+                if (maxCodeLength < 0 || maxCodeLength > 255) {
+                    throw std::out_of_range("max-code-length");
+                }
+            } catch (const std::exception&) {
+                std::cerr << "Invalid maximum code length: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--solid") {
+            solid = true;
+        } else if (arg == "--no-table-reuse") {
+            noTableReuse = true;
+        } else if (arg == "--pairs") {
+            pairAlphabet = true;
+        } else if (arg == "--no-dedup") {
+            noDedup = true;
+        } else if (arg == "--single-pass") {
+            singlePass = true;
+        } else if (arg.rfind("--sample=", 0) == 0) {
+            try {
+                long long value = std::stoll(arg.substr(std::string("--sample=").size()));
+                if (value < 1) {
+                    throw std::out_of_range("sample");
+                }
+                sampleInterval = static_cast<size_t>(value);
+            } catch (const std::exception&) {
+                std::cerr << "Invalid sample interval: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            singlePass = true;
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            try {
+                long long value = std::stoll(arg.substr(std::string("--threads=").size()));
+                if (value < 1) {
+                    throw std::out_of_range("threads");
+                }
+                threadCount = static_cast<size_t>(value);
+            } catch (const std::exception&) {
+                std::cerr << "Invalid thread count: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg.rfind("--flush-interval=", 0) == 0) {
+            if (!parseSize(arg.substr(std::string("--flush-interval=").size()), flushInterval)) {
+                std::cerr << "Invalid flush interval: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--fsync") {
+            syncOutput = true;
+        } else if (arg == "--no-fsync") {
+            syncOutput = false;
+        } else if (arg.rfind("--volume-size=", 0) == 0) {
+            if (!parseSize(arg.substr(std::string("--volume-size=").size()), volumeSize) || volumeSize == 0) {
+                std::cerr << "Invalid volume size: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg.rfind("--volume-dir=", 0) == 0) {
+            volumeDirs.push_back(arg.substr(std::string("--volume-dir=").size()));
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            tracePath = arg.substr(std::string("--trace=").size());
+        } else if (arg.rfind("--force-isa=", 0) == 0) {
+            forcedIsa = arg.substr(std::string("--force-isa=").size());
+        } else if (arg == "--hash") {
+            hash = true;
+        } else if (arg.rfind("--incremental=", 0) == 0) {
+            incrementalBase = arg.substr(std::string("--incremental=").size());
+        } else if (arg == "--incremental") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for --incremental" << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            incrementalBase = argv[++i];
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    // append 接受多个输入路径，analyze、serve、batch 只有一个参数，其余命令固定为 <input> <output>
+    bool isAppend = !args.empty() && args[0] == "append";
+    bool singleArgument = !args.empty() && (args[0] == "analyze" || args[0] == "serve" || args[0] == "batch");
+    if (isAppend ? args.size() < 3 : args.size() != (singleArgument ? 2u : 3u)) {
         printUsage(argv[0]);
         return 1;
     }
 
-    std::string command = argv[1];
-    std::string input = argv[2];
-    std::string output = argv[3];
+    std::string command = args[0];
+    std::string input = args[1];
+    std::string output = singleArgument ? std::string() : args[2];
 
     try {
+        if (!tracePath.empty()) {
+            Tracer::start(tracePath);
+        }
+        if (!forcedIsa.empty()) {
+            CpuDispatch::forceIsa(forcedIsa);
+        }
+
+        // 先取级别预设，再用显式给出的选项逐项覆盖
+        HuffmanCompressor::CompressionOptions options = HuffmanCompressor::CompressionOptions::preset(level);
+        if (solid) {
+            options.solid = true;
+        }
+        if (singlePass) {
+            options.singlePass = true;
+        }
+        if (noTableReuse) {
+            options.reuseTables = false;
+        }
+        if (pairAlphabet) {
+            options.pairAlphabet = true;
+        }
+        if (noDedup) {
+            options.deduplicate = false;
+        }
+        if (sampleInterval > 0) {
+            options.sampleInterval = sampleInterval;
+        }
+        if (blockSize > 0) {
+            options.blockSize = blockSize;
+        }
+        if (adaptiveSplit) {
+            options.adaptiveSplit = true;
+        }
+        if (minBlockSize > 0) {
+            options.minBlockSize = minBlockSize;
+        }
+        if (maxCodeLength >= 0) {
+            options.maxCodeLength = static_cast<unsigned>(maxCodeLength);
+        }
+
+        if (command == "serve") {
+            CompressionServer server(options, threadCount);
+            server.setSyncOutput(syncOutput);
+            server.setContentHash(hash);
+            server.setFlushInterval(flushInterval);
+            server.serve(input);
+            return 0;
+        }
+        if (command == "batch") {
+            BatchRunner runner(options, threadCount);
+            runner.setStatsFormat(statsFormat);
+            runner.setSyncOutput(syncOutput);
+            runner.setContentHash(hash);
+            runner.setFlushInterval(flushInterval);
+            if (input == "-") {
+                return runner.run(std::cin, std::cout) ? 0 : 1;
+            }
+            std::ifstream jobList(input);
+            if (!jobList) {
+                throw std::runtime_error("Failed to open job list: " + input);
+            }
+            return runner.run(jobList, std::cout) ? 0 : 1;
+        }
+
         HuffmanCompressor compressor;
+        compressor.setStatsFormat(statsFormat);
+        compressor.setOptions(options);
+        compressor.setIncrementalBase(incrementalBase);
+        compressor.setContentHash(hash);
+        compressor.setThreadCount(threadCount);
+        compressor.setSyncOutput(syncOutput);
+        compressor.setFlushInterval(flushInterval);
+        compressor.setVolumes(volumeSize, volumeDirs);
 
         if (command == "compress-file") {
             compressor.compressFile(input, output);
@@ -37,6 +332,14 @@ int main(int argc, char* argv[]) {
             compressor.compressDirectory(input, output);
         } else if (command == "decompress") {
             compressor.decompress(input, output);
+        } else if (command == "compress-stream") {
+            compressor.compressStream(input, output);
+        } else if (command == "decompress-stream") {
+            compressor.decompressStream(input, output);
+        } else if (command == "analyze") {
+            compressor.analyze(input);
+        } else if (command == "append") {
+            compressor.appendToArchive(input, std::vector<std::string>(args.begin() + 2, args.end()));
         } else {
             std::cerr << "Unknown command: " << command << std::endl;
             printUsage(argv[0]);
@@ -49,4 +352,4 @@ int main(int argc, char* argv[]) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,525 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/HuffmanCompressor.hpp"
+#include "../include/BatchRunner.hpp"
+#include "../include/CompressionServer.hpp"
+#include "../include/VolumeSet.hpp"
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ * 归档功能测试：每项在临时目录中生成输入，压缩后解压，逐字节比较还原结果
+ */
+
+namespace fs = std::filesystem;
+
+void check(bool condition, const std::string& message) {
+    if (!condition) {
+        throw std::runtime_error("Check failed: " + message);
+    }
+}
+
+// 固定种子生成的可压缩文本
+std::string makeText(size_t size, uint64_t seed) {
+    static const char* const words[] = {
+        "huffman", "archive", "block", "stream", "table", "symbol", "the", "of", "and", "to", "a", "in"
+    };
+    std::string text;
+    uint64_t state = seed * 2654435761u + 1;
+    while (text.size() < size) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        text += words[state % (sizeof(words) / sizeof(words[0]))];
+        text += state % 11 == 0 ? '\n' : ' ';
+    }
+    text.resize(size);
+    return text;
+}
+
+void writeFile(const fs::path& path, const std::string& data) {
+    fs::create_directories(path.parent_path());
+    std::ofstream file(path, std::ios::binary);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + path.string());
+    }
+}
+
+std::string readFile(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open file: " + path.string());
+    }
+    std::ostringstream data;
+    data << file.rdbuf();
+    return data.str();
+}
+
+// 两棵目录树的文件、目录和内容完全一致
+bool sameTree(const fs::path& expected, const fs::path& actual) {
+    size_t expectedCount = 0;
+    for (const auto& entry : fs::recursive_directory_iterator(expected)) {
+        expectedCount++;
+        fs::path other = actual / fs::relative(entry.path(), expected);
+        if (entry.is_directory() ? !fs::is_directory(other)
+                                 : !fs::is_regular_file(other) || readFile(entry.path()) != readFile(other)) {
+            return false;
+        }
+    }
+    size_t actualCount = std::distance(fs::recursive_directory_iterator(actual), fs::recursive_directory_iterator());
+    return expectedCount == actualCount;
+}
+
+// 每项测试使用独立的临时目录
+class Workspace {
+public:
+    explicit Workspace(const std::string& name)
+        : root_(fs::temp_directory_path() / ("huffzip_test_" + std::to_string(getpid()) + "_" + name)) {
+        fs::remove_all(root_);
+        fs::create_directories(root_);
+    }
+
+    ~Workspace() {
+        std::error_code error;
+        fs::remove_all(root_, error);
+    }
+
+    fs::path path(const std::string& name) const {
+        return root_ / name;
+    }
+
+private:
+    fs::path root_;
+};
+
+// 统计信息不输出到终端
+class QuietCompressor : public HuffmanCompressor {
+public:
+    QuietCompressor() {
+        setStatsOutput(&discarded_);
+        setSyncOutput(false);
+    }
+
+private:
+    std::ostringstream discarded_;
+};
+
+// 追加文件和目录后全部成员都能解出
+void testAppend() {
+    std::cout << "Testing append..." << std::endl;
+    Workspace workspace("append");
+    fs::path tree = workspace.path("tree");
+    writeFile(tree / "a.txt", makeText(40000, 1));
+    writeFile(tree / "sub/b.txt", makeText(3000, 2));
+    writeFile(workspace.path("extra/c.log"), makeText(70000, 3));
+    writeFile(workspace.path("extra/more/d.txt"), makeText(500, 4));
+    writeFile(workspace.path("single.txt"), makeText(9000, 5));
+
+    QuietCompressor compressor;
+    std::string archive = workspace.path("tree.huff").string();
+    compressor.compressDirectory(tree.string(), archive);
+    compressor.appendToArchive(archive, {workspace.path("extra").string(), workspace.path("single.txt").string()});
+
+    fs::path expected = workspace.path("expected");
+    fs::copy(tree, expected, fs::copy_options::recursive);
+    fs::copy(workspace.path("extra"), expected / "extra", fs::copy_options::recursive);
+    fs::copy(workspace.path("single.txt"), expected / "single.txt");
+
+    fs::path output = workspace.path("out");
+    compressor.decompress(archive, output.string());
+    check(sameTree(expected, output), "appended archive restores every member");
+    std::cout << "Append test passed!" << std::endl;
+}
+
+// 追加中途失败（写入超出文件大小限制）后归档保持追加前的内容
+void testFailedAppend() {
+    std::cout << "Testing failed append..." << std::endl;
+    Workspace workspace("failed_append");
+    fs::path tree = workspace.path("tree");
+    writeFile(tree / "a.txt", makeText(50000, 6));
+    writeFile(tree / "b.txt", makeText(20000, 7));
+
+    // 随机字节几乎不可压缩，追加的数据块必然超出限制
+    std::string random(1 << 20, '\0');
+    uint64_t state = 88172645463325252ull;
+    for (char& c : random) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        c = static_cast<char>(state >> 56);
+    }
+    writeFile(workspace.path("large.bin"), random);
+
+    QuietCompressor compressor;
+    std::string archive = workspace.path("tree.huff").string();
+    compressor.compressDirectory(tree.string(), archive);
+    uintmax_t archiveSize = fs::file_size(archive);
+
+    struct rlimit previous;
+    getrlimit(RLIMIT_FSIZE, &previous);
+    struct rlimit limited = previous;
+    limited.rlim_cur = static_cast<rlim_t>(archiveSize + (64 << 10));
+    auto previousHandler = std::signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &limited);
+    bool failed = false;
+    try {
+        compressor.appendToArchive(archive, {workspace.path("large.bin").string()});
+    } catch (const std::exception&) {
+        failed = true;
+    }
+    setrlimit(RLIMIT_FSIZE, &previous);
+    std::signal(SIGXFSZ, previousHandler);
+
+    check(failed, "append beyond the file size limit fails");
+    check(fs::file_size(archive) == archiveSize, "failed append restores the archive length");
+    fs::path output = workspace.path("out");
+    compressor.decompress(archive, output.string());
+    check(sameTree(tree, output), "archive is still extractable after a failed append");
+    std::cout << "Failed append test passed!" << std::endl;
+}
+
+// 增量压缩沿用未修改文件的数据块，还原结果与当前目录一致
+void testIncremental() {
+    std::cout << "Testing incremental compression..." << std::endl;
+    Workspace workspace("incremental");
+    fs::path tree = workspace.path("tree");
+    writeFile(tree / "a.txt", makeText(60000, 11));
+    writeFile(tree / "sub/b.txt", makeText(8000, 12));
+    writeFile(tree / "sub/c.txt", makeText(25000, 13));
+
+    QuietCompressor first;
+    std::string base = workspace.path("base.huff").string();
+    first.compressDirectory(tree.string(), base);
+
+    // 修改一个文件并新增一个文件，其余保持不变
+    writeFile(tree / "sub/c.txt", makeText(26000, 14));
+    writeFile(tree / "d.txt", makeText(4000, 15));
+
+    QuietCompressor second;
+    second.setIncrementalBase(base);
+    std::string archive = workspace.path("next.huff").string();
+    second.compressDirectory(tree.string(), archive);
+    check(second.getCompressionStats().filesReused > 0, "unchanged files are copied from the base archive");
+
+    fs::path output = workspace.path("out");
+    second.decompress(archive, output.string());
+    check(sameTree(tree, output), "incremental archive restores the current tree");
+    std::cout << "Incremental test passed!" << std::endl;
+}
+
+// 流式压缩按间隔插入刷新点，刷新点处补齐字节后解码仍能接续
+void testStream() {
+    std::cout << "Testing stream compression..." << std::endl;
+    Workspace workspace("stream");
+    // 不是读取块大小的整数倍，最后不足一块时也会输出刷新点
+    std::string original = makeText(300000, 16);
+    writeFile(workspace.path("input.txt"), original);
+
+    QuietCompressor compressor;
+    compressor.setFlushInterval(100000);
+    std::string archive = workspace.path("input.huffs").string();
+    compressor.compressStream(workspace.path("input.txt").string(), archive);
+
+    // 不插入刷新点的归档更短，说明上面的归档确实包含刷新点
+    QuietCompressor plain;
+    std::string plainArchive = workspace.path("plain.huffs").string();
+    plain.setFlushInterval(0);
+    plain.compressStream(workspace.path("input.txt").string(), plainArchive);
+    check(fs::file_size(archive) > fs::file_size(plainArchive), "flush interval adds flush points");
+
+    compressor.decompressStream(archive, workspace.path("output.txt").string());
+    check(readFile(workspace.path("output.txt")) == original, "stream archive restores the input");
+    std::cout << "Stream test passed!" << std::endl;
+}
+
+// 最高级别对文本块改用字节对字母表，解码时每次查表可能解出两个字节
+void testPairAlphabet() {
+    std::cout << "Testing pair alphabet..." << std::endl;
+    Workspace workspace("pairs");
+    // 超过一个块，末尾一块不满
+    std::string original = makeText(1500000, 17);
+    writeFile(workspace.path("input.txt"), original);
+
+    QuietCompressor compressor;
+    compressor.setOptions(HuffmanCompressor::CompressionOptions::preset(HuffmanCompressor::Level::MAX));
+    std::string archive = workspace.path("input.huff").string();
+    compressor.compressFile(workspace.path("input.txt").string(), archive);
+    check(compressor.getCompressionStats().pairBlocks > 0, "text blocks use the pair alphabet");
+
+    compressor.decompressFile(archive, workspace.path("output.txt").string());
+    check(readFile(workspace.path("output.txt")) == original, "pair blocks restore the input");
+    std::cout << "Pair alphabet test passed!" << std::endl;
+}
+
+// 内容相同的文件只编码一次，每个副本都能按原路径还原
+void testDeduplicate() {
+    std::cout << "Testing deduplication..." << std::endl;
+    Workspace workspace("dedup");
+    fs::path tree = workspace.path("tree");
+    std::string shared = makeText(50000, 18);
+    std::string small = makeText(700, 19);
+    writeFile(tree / "a.txt", shared);
+    writeFile(tree / "copy/a.txt", shared);
+    writeFile(tree / "copy/b.txt", shared);
+    writeFile(tree / "small.txt", small);
+    writeFile(tree / "copy/small.txt", small);
+    writeFile(tree / "other.txt", makeText(50000, 20));
+
+    // 非固实目录和固实目录（小文件拼接进同一块）各测一次
+    for (auto level : {HuffmanCompressor::Level::DEFAULT, HuffmanCompressor::Level::MAX}) {
+        QuietCompressor compressor;
+        compressor.setOptions(HuffmanCompressor::CompressionOptions::preset(level));
+        std::string archive = workspace.path("tree.huff").string();
+        compressor.compressDirectory(tree.string(), archive);
+        check(compressor.getCompressionStats().filesDeduplicated == 3, "duplicate files are stored once");
+
+        fs::path output = workspace.path("out");
+        fs::remove_all(output);
+        compressor.decompress(archive, output.string());
+        check(sameTree(tree, output), "every duplicate is restored");
+    }
+    std::cout << "Deduplication test passed!" << std::endl;
+}
+
+// 按固定大小切分的分卷：数据块跨越卷边界，解压时按归档偏移拼接各卷
+void testVolumes() {
+    std::cout << "Testing multi-volume output..." << std::endl;
+    Workspace workspace("volumes");
+    const uint64_t volumeSize = VolumeSet::MIN_VOLUME_SIZE;
+    std::string original = makeText(600000, 21);
+    writeFile(workspace.path("input.txt"), original);
+    fs::path tree = workspace.path("tree");
+    writeFile(tree / "a.txt", makeText(200000, 22));
+    writeFile(tree / "sub/b.txt", makeText(150000, 23));
+    writeFile(tree / "sub/c.txt", makeText(900, 24));
+
+    // 单文件归档，各卷与归档在同一目录
+    QuietCompressor compressor;
+    compressor.setVolumes(volumeSize, {});
+    std::string archive = workspace.path("input.huff").string();
+    compressor.compressFile(workspace.path("input.txt").string(), archive);
+    check(!fs::exists(archive), "multi-volume output has no unsplit archive");
+    check(fs::file_size(archive + ".001") == volumeSize && fs::file_size(archive + ".002") == volumeSize &&
+          fs::exists(archive + ".003"), "volumes are cut at the volume size");
+
+    QuietCompressor reader;
+    reader.decompress(archive, workspace.path("file_out").string());
+    check(readFile(workspace.path("file_out/input.txt")) == original, "single-file volumes restore the input");
+
+    // 目录归档，各卷轮流写入两个目录，解压时给出同样的目录
+    std::vector<std::string> directories = {workspace.path("disk1").string(), workspace.path("disk2").string()};
+    for (const auto& directory : directories) {
+        fs::create_directories(directory);
+    }
+    compressor.setVolumes(volumeSize, directories);
+    archive = workspace.path("tree.huff").string();
+    compressor.compressDirectory(tree.string(), archive);
+    check(fs::exists(directories[0] + "/tree.huff.001") && fs::exists(directories[1] + "/tree.huff.002") &&
+          fs::exists(directories[0] + "/tree.huff.003"), "volumes alternate between the directories");
+
+    reader.setVolumes(0, directories);
+    fs::path output = workspace.path("tree_out");
+    reader.decompress(archive, output.string());
+    check(sameTree(tree, output), "directory volumes restore the tree");
+    std::cout << "Multi-volume test passed!" << std::endl;
+}
+
+// 向服务发送一个请求：fds 随请求行通过 SCM_RIGHTS 传递，inlineInput 在请求行之后发送
+// 返回响应行（不含换行），响应行之后的内联输出写入 inlineOutput
+std::string request(const std::string& socketPath, const std::string& line, const std::vector<int>& fds,
+                    const std::string& inlineInput, std::string& inlineOutput) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    // 服务线程可能尚未开始监听
+    int connection = -1;
+    for (int attempt = 0; attempt < 500 && connection < 0; ++attempt) {
+        connection = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            close(connection);
+            connection = -1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    check(connection >= 0, "connect to " + socketPath);
+
+    std::string text = line + "\n";
+    iovec io{const_cast<char*>(text.data()), text.size()};
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 2)];
+    if (!fds.empty()) {
+        message.msg_control = control;
+        message.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        std::memcpy(CMSG_DATA(header), fds.data(), sizeof(int) * fds.size());
+    }
+    check(sendmsg(connection, &message, 0) == static_cast<ssize_t>(text.size()), "send request line");
+    // 不带内联数据的请求（如 shutdown）服务端可能已经关闭连接，不能再写
+    if (!inlineInput.empty()) {
+        check(write(connection, inlineInput.data(), inlineInput.size()) == static_cast<ssize_t>(inlineInput.size()),
+              "send inline input");
+    }
+    shutdown(connection, SHUT_WR);
+
+    std::string response;
+    char buffer[65536];
+    ssize_t count;
+    while ((count = read(connection, buffer, sizeof(buffer))) > 0) {
+        response.append(buffer, static_cast<size_t>(count));
+    }
+    close(connection);
+
+    size_t newline = response.find('\n');
+    check(newline != std::string::npos, "response line for " + line);
+    inlineOutput = response.substr(newline + 1);
+    return response.substr(0, newline);
+}
+
+// 服务的内联数据和描述符传递：压缩后记录给定的文件名，解压写出单文件归档的成员
+void testServer() {
+    std::cout << "Testing serve..." << std::endl;
+    Workspace workspace("serve");
+    std::string original = makeText(300000, 8);
+    writeFile(workspace.path("input.txt"), original);
+    writeFile(workspace.path("tree/a.txt"), makeText(1000, 9));
+    std::string socketPath = workspace.path("huffzip.sock").string();
+
+    CompressionServer server(HuffmanCompressor::CompressionOptions::preset(HuffmanCompressor::Level::DEFAULT), 2);
+    server.setSyncOutput(false);
+    std::thread serverThread([&] { server.serve(socketPath); });
+
+    try {
+        // 内联压缩、内联解压
+        std::string archive;
+        std::string response = request(socketPath, "compress-file\t-\t-\tnotes.txt", {}, original, archive);
+        check(response.rfind("OK ", 0) == 0, "inline compress-file: " + response);
+        std::string restored;
+        response = request(socketPath, "decompress\t-\t-", {}, archive, restored);
+        check(response.rfind("OK ", 0) == 0, "inline decompress: " + response);
+        check(restored == original, "inline round trip restores the data");
+
+        // 归档中记录的是请求给出的文件名
+        writeFile(workspace.path("inline.huff"), archive);
+        QuietCompressor compressor;
+        compressor.decompress(workspace.path("inline.huff").string(), workspace.path("named").string());
+        check(readFile(workspace.path("named/notes.txt")) == original, "member name from the request");
+
+        // 描述符压缩、描述符解压
+        int input = open(workspace.path("input.txt").c_str(), O_RDONLY);
+        int output = open(workspace.path("fd.huff").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        std::string unused;
+        response = request(socketPath, "compress-file\t-\t-\tfd.txt", {input, output}, std::string(), unused);
+        close(input);
+        close(output);
+        check(response.rfind("OK ", 0) == 0, "fd compress-file: " + response);
+
+        input = open(workspace.path("fd.huff").c_str(), O_RDONLY);
+        output = open(workspace.path("fd.txt").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        response = request(socketPath, "decompress\t-\t-", {input, output}, std::string(), unused);
+        close(input);
+        close(output);
+        check(response.rfind("OK ", 0) == 0, "fd decompress: " + response);
+        check(readFile(workspace.path("fd.txt")) == original, "fd round trip restores the data");
+
+        // analyze 的估计结果随响应返回，不写到服务的标准输出
+        response = request(socketPath, "analyze\t" + workspace.path("input.txt").string() + "\t-", {}, std::string(),
+                           unused);
+        check(response.rfind("OK 0 {\"operation\":\"analyze\"", 0) == 0, "analyze returns its estimates: " + response);
+
+        // 目录归档不能写到单个输出
+        compressor.compressDirectory(workspace.path("tree").string(), workspace.path("tree.huff").string());
+        response = request(socketPath, "decompress\t-\t-", {}, readFile(workspace.path("tree.huff")), unused);
+        check(response.rfind("ERROR ", 0) == 0, "directory archive to a single output is rejected");
+    } catch (...) {
+        std::string unused;
+        request(socketPath, "shutdown", {}, std::string(), unused);
+        serverThread.join();
+        throw;
+    }
+
+    std::string unused;
+    request(socketPath, "shutdown", {}, std::string(), unused);
+    serverThread.join();
+    std::cout << "Serve test passed!" << std::endl;
+}
+
+// 批量任务：格式错误和失败的任务不影响其他任务，汇总按任务列表顺序列出每个任务的状态
+void testBatch() {
+    std::cout << "Testing batch..." << std::endl;
+    Workspace workspace("batch");
+    std::string original = makeText(200000, 25);
+    writeFile(workspace.path("input.txt"), original);
+    std::string archive = workspace.path("input.huff").string();
+
+    std::istringstream jobs(
+        "# 注释行和空行忽略\n"
+        "\n"
+        "compress-file\t" + workspace.path("input.txt").string() + "\t" + archive + "\n"
+        "compress-file only-one-field\n"
+        "compress-file\t" + workspace.path("missing.txt").string() + "\t" + workspace.path("missing.huff").string() +
+        "\n");
+    BatchRunner runner(HuffmanCompressor::CompressionOptions::preset(HuffmanCompressor::Level::DEFAULT), 2);
+    runner.setStatsFormat(HuffmanCompressor::StatsFormat::JSON);
+    std::ostringstream summary;
+    check(!runner.run(jobs, summary), "batch with failed jobs reports failure");
+
+    QuietCompressor compressor;
+    compressor.decompressFile(archive, workspace.path("output.txt").string());
+    check(readFile(workspace.path("output.txt")) == original, "successful job round-trips");
+
+    std::string json = summary.str();
+    size_t good = json.find("{\"line\":3,\"command\":\"compress-file\"");
+    size_t malformed = json.find("{\"line\":4,\"command\":\"compress-file\"");
+    size_t missing = json.find("{\"line\":5,\"command\":\"compress-file\"");
+    check(good != std::string::npos && malformed != std::string::npos && missing != std::string::npos &&
+          good < malformed && malformed < missing, "summary lists the jobs in line order: " + json);
+    check(json.find("\"status\":\"ok\"", good) < malformed, "first job succeeds: " + json);
+    check(json.find("\"status\":\"error\"", malformed) < missing, "malformed line fails: " + json);
+    check(json.find("\"status\":\"error\"", missing) != std::string::npos, "missing input fails: " + json);
+    check(json.find("\"succeeded\":1,\"failed\":2") != std::string::npos, "summary counts: " + json);
+    std::cout << "Batch test passed!" << std::endl;
+}
+
+int main() {
+    try {
+        testAppend();
+        testFailedAppend();
+        testIncremental();
+        testStream();
+        testPairAlphabet();
+        testDeduplicate();
+        testVolumes();
+        testServer();
+        testBatch();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,363 @@
+//
+// Created by Musubi on 2026/1/18.
+//
+
+#include "../include/HuffmanCompressor.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+ * 性能回归测试
+ * 1. 生成固定的测试语料（文本、随机字节、两者交替），每份 CORPUS_SIZE 字节
+ * 2. 以 fast / default / max 三个级别压缩并解压，轮流重复 repeat 轮，每项取最快的一次
+ * 3. 与基准 JSON 比较：吞吐量下降超过 tolerance 或压缩率变差超过 ratioTolerance 时失败
+ *    --update 时把本次结果写回基准文件
+ */
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+const size_t CORPUS_SIZE = 8 << 20;
+const size_t MIXED_SEGMENT = 256 << 10;
+
+// 一项测试的结果
+struct Result {
+    double compressMBps;
+    double decompressMBps;
+    double ratio;  // 压缩后大小 / 原始大小
+};
+
+// 固定种子的 xorshift64，保证每次生成相同的语料
+class Generator {
+public:
+    explicit Generator(uint64_t seed) : state_(seed) {}
+
+    uint64_t next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+private:
+    uint64_t state_;
+};
+
+// 由常用词拼成的英文文本，词频大致按 Zipf 分布
+std::vector<uint8_t> makeText(size_t size, uint64_t seed) {
+    static const char* const words[] = {
+        "the", "of", "and", "to", "in", "a", "is", "that", "for", "it", "as", "was", "with", "be", "by",
+        "on", "not", "he", "this", "are", "or", "his", "from", "at", "which", "but", "have", "an", "had",
+        "they", "you", "were", "their", "one", "all", "we", "can", "her", "has", "there", "been", "if",
+        "more", "when", "will", "would", "who", "so", "no", "compression", "huffman", "archive", "block",
+        "stream", "table", "symbol", "frequency", "decoder", "encoder", "buffer", "thread", "pipeline"
+    };
+    const size_t wordCount = sizeof(words) / sizeof(words[0]);
+
+    Generator generator(seed);
+    std::vector<uint8_t> data;
+    data.reserve(size + 32);
+    size_t lineLength = 0;
+    while (data.size() < size) {
+        // 两个均匀数取较小值，使靠前的词出现得更多
+        size_t index = std::min(generator.next() % wordCount, generator.next() % wordCount);
+        for (const char* c = words[index]; *c; ++c) {
+            data.push_back(static_cast<uint8_t>(*c));
+        }
+        lineLength += std::char_traits<char>::length(words[index]) + 1;
+        if (lineLength > 72) {
+            data.push_back('\n');
+            lineLength = 0;
+        } else {
+            data.push_back(' ');
+        }
+    }
+    data.resize(size);
+    return data;
+}
+
+std::vector<uint8_t> makeRandom(size_t size, uint64_t seed) {
+    Generator generator(seed);
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(generator.next() >> 56);
+    }
+    return data;
+}
+
+// 文本与随机字节按 MIXED_SEGMENT 交替，统计特征在段边界突变
+std::vector<uint8_t> makeMixed(size_t size, uint64_t seed) {
+    std::vector<uint8_t> text = makeText(size, seed);
+    std::vector<uint8_t> random = makeRandom(size, seed + 1);
+    std::vector<uint8_t> data(size);
+    for (size_t offset = 0; offset < size; offset += MIXED_SEGMENT) {
+        size_t length = std::min(MIXED_SEGMENT, size - offset);
+        const std::vector<uint8_t>& source = (offset / MIXED_SEGMENT) % 2 == 0 ? text : random;
+        std::copy(source.begin() + offset, source.begin() + offset + length, data.begin() + offset);
+    }
+    return data;
+}
+
+void writeFile(const fs::path& path, const std::vector<uint8_t>& data) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + path.string());
+    }
+}
+
+// 逐块比较两个文件的内容
+bool sameContents(const fs::path& a, const fs::path& b) {
+    std::ifstream fileA(a, std::ios::binary);
+    std::ifstream fileB(b, std::ios::binary);
+    if (!fileA || !fileB) {
+        return false;
+    }
+    std::vector<char> bufferA(1 << 20);
+    std::vector<char> bufferB(1 << 20);
+    while (true) {
+        fileA.read(bufferA.data(), static_cast<std::streamsize>(bufferA.size()));
+        fileB.read(bufferB.data(), static_cast<std::streamsize>(bufferB.size()));
+        std::streamsize countA = fileA.gcount();
+        if (countA != fileB.gcount() || !std::equal(bufferA.begin(), bufferA.begin() + countA, bufferB.begin())) {
+            return false;
+        }
+        if (countA == 0) {
+            return true;
+        }
+    }
+}
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 压缩并解压一份语料一次；顺带检查解压结果与原文件一致
+Result measureOnce(const fs::path& corpus, HuffmanCompressor::Level level, const fs::path& workDir) {
+    HuffmanCompressor compressor;
+    std::ostringstream discarded;
+    compressor.setStatsOutput(&discarded);
+    compressor.setOptions(HuffmanCompressor::CompressionOptions::preset(level));
+    compressor.setSyncOutput(false);
+    compressor.setThreadCount(1);
+
+    fs::path archive = workDir / "archive.huff";
+    fs::path outputDir = workDir / "out";
+    auto start = Clock::now();
+    compressor.compressFile(corpus.string(), archive.string());
+    double compressSeconds = secondsSince(start);
+
+    fs::remove_all(outputDir);
+    fs::create_directories(outputDir);
+    start = Clock::now();
+    compressor.decompress(archive.string(), outputDir.string());
+    double decompressSeconds = secondsSince(start);
+
+    fs::path restored = outputDir / corpus.filename();
+    if (!fs::exists(restored) || fs::file_size(restored) != fs::file_size(corpus) ||
+        !sameContents(restored, corpus)) {
+        throw std::runtime_error("Round trip failed for " + corpus.string());
+    }
+
+    double size = static_cast<double>(fs::file_size(corpus));
+    return Result{
+        size / compressSeconds / 1e6,
+        size / decompressSeconds / 1e6,
+        static_cast<double>(fs::file_size(archive)) / size
+    };
+}
+
+// 基准文件由 writeBaseline 生成，每行一项："name":{...}
+double numberField(const std::string& object, const std::string& key) {
+    std::string pattern = "\"" + key + "\":";
+    size_t pos = object.find(pattern);
+    if (pos == std::string::npos) {
+        throw std::runtime_error("Baseline entry has no field " + key + ": " + object);
+    }
+    return std::stod(object.substr(pos + pattern.size()));
+}
+
+std::map<std::string, Result> readBaseline(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open baseline: " + path + " (run with --update to create it)");
+    }
+    std::map<std::string, Result> baseline;
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t nameStart = line.find('"');
+        size_t objectStart = line.find("{\"compressMBps\"");
+        if (nameStart == std::string::npos || objectStart == std::string::npos) {
+            continue;
+        }
+        size_t nameEnd = line.find('"', nameStart + 1);
+        std::string name = line.substr(nameStart + 1, nameEnd - nameStart - 1);
+        std::string object = line.substr(objectStart);
+        baseline[name] = Result{
+            numberField(object, "compressMBps"),
+            numberField(object, "decompressMBps"),
+            numberField(object, "ratio")
+        };
+    }
+    return baseline;
+}
+
+void writeBaseline(const std::string& path, const std::map<std::string, Result>& results) {
+    std::ofstream file(path);
+    file << std::fixed;
+    file << "{\"corpusSize\":" << CORPUS_SIZE << ",\"results\":{" << std::endl;
+    size_t index = 0;
+    for (const auto& entry : results) {
+        file << "  \"" << entry.first << "\":{"
+             << std::setprecision(1)
+             << "\"compressMBps\":" << entry.second.compressMBps
+             << ",\"decompressMBps\":" << entry.second.decompressMBps
+             << std::setprecision(6)
+             << ",\"ratio\":" << entry.second.ratio << "}"
+             << (++index < results.size() ? "," : "") << std::endl;
+    }
+    file << "}}" << std::endl;
+    if (!file) {
+        throw std::runtime_error("Failed to write baseline: " + path);
+    }
+}
+
+// 输出一行比较结果；higherIsBetter 为 false 时数值变大视为变差，返回是否回退
+bool compareMetric(const std::string& name, const std::string& metric, double baseline, double current,
+                   double tolerance, bool higherIsBetter) {
+    double change = baseline != 0.0 ? (current - baseline) / baseline : 0.0;
+    double worse = higherIsBetter ? -change : change;
+    const char* status = worse > tolerance ? "REGRESSED" : (worse < -tolerance ? "improved" : "ok");
+
+    std::cout << std::left << std::setw(18) << name << std::setw(16) << metric << std::right
+              << std::setw(12) << baseline << std::setw(12) << current
+              << std::setw(9) << std::showpos << change * 100.0 << std::noshowpos << "%  "
+              << status << std::endl;
+    return worse > tolerance;
+}
+
+int main(int argc, char* argv[]) {
+    std::string baselinePath;
+    double tolerance = 0.5;
+    double ratioTolerance = 0.01;
+    size_t repeat = 5;
+    bool update = false;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--tolerance=", 0) == 0) {
+                tolerance = std::stod(arg.substr(std::string("--tolerance=").size()));
+            } else if (arg.rfind("--ratio-tolerance=", 0) == 0) {
+                ratioTolerance = std::stod(arg.substr(std::string("--ratio-tolerance=").size()));
+            } else if (arg.rfind("--repeat=", 0) == 0) {
+                repeat = std::max<size_t>(1, std::stoul(arg.substr(std::string("--repeat=").size())));
+            } else if (arg == "--update") {
+                update = true;
+            } else {
+                baselinePath = arg;
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid argument" << std::endl;
+        return 1;
+    }
+    if (baselinePath.empty()) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <baseline.json> [--tolerance=F] [--ratio-tolerance=F] [--repeat=N] [--update]" << std::endl;
+        return 1;
+    }
+
+    fs::path workDir = fs::temp_directory_path() /
+        ("huffzip-perf-" + std::to_string(Clock::now().time_since_epoch().count()));
+    bool regressed = false;
+
+    try {
+        fs::create_directories(workDir);
+
+        const std::pair<const char*, std::vector<uint8_t> (*)(size_t, uint64_t)> corpora[] = {
+            {"text", makeText}, {"random", makeRandom}, {"mixed", makeMixed}
+        };
+        const std::pair<const char*, HuffmanCompressor::Level> levels[] = {
+            {"fast", HuffmanCompressor::Level::FAST},
+            {"default", HuffmanCompressor::Level::DEFAULT},
+            {"max", HuffmanCompressor::Level::MAX}
+        };
+
+        std::vector<fs::path> corpusPaths;
+        for (const auto& corpus : corpora) {
+            corpusPaths.push_back(workDir / (std::string(corpus.first) + ".dat"));
+            writeFile(corpusPaths.back(), corpus.second(CORPUS_SIZE, 0x9E3779B97F4A7C15ull));
+        }
+
+        // 每轮把全部组合各跑一次、共 repeat 轮，各项取最快的一次；
+        // 机器一段时间内整体变慢时只影响每项的个别样本，而不是某一项的全部样本
+        std::map<std::string, Result> results;
+        for (size_t round = 0; round < repeat; ++round) {
+            for (size_t c = 0; c < corpusPaths.size(); ++c) {
+                for (const auto& level : levels) {
+                    Result sample = measureOnce(corpusPaths[c], level.second, workDir);
+                    std::string name = std::string(corpora[c].first) + "/" + level.first;
+                    auto found = results.find(name);
+                    if (found == results.end()) {
+                        results[name] = sample;
+                    } else {
+                        found->second.compressMBps = std::max(found->second.compressMBps, sample.compressMBps);
+                        found->second.decompressMBps = std::max(found->second.decompressMBps, sample.decompressMBps);
+                    }
+                }
+            }
+        }
+
+        if (update) {
+            writeBaseline(baselinePath, results);
+            std::cout << "Baseline written to " << baselinePath << std::endl;
+        } else {
+            std::map<std::string, Result> baseline = readBaseline(baselinePath);
+            std::cout << std::fixed << std::setprecision(3);
+            std::cout << std::left << std::setw(18) << "benchmark" << std::setw(16) << "metric" << std::right
+                      << std::setw(12) << "baseline" << std::setw(12) << "current"
+                      << std::setw(10) << "change" << "  status" << std::endl;
+            for (const auto& entry : results) {
+                auto found = baseline.find(entry.first);
+                if (found == baseline.end()) {
+                    std::cout << std::left << std::setw(18) << entry.first << "not in baseline" << std::endl;
+                    continue;
+                }
+                const Result& before = found->second;
+                const Result& now = entry.second;
+                regressed |= compareMetric(entry.first, "compress MB/s", before.compressMBps, now.compressMBps,
+                                           tolerance, true);
+                regressed |= compareMetric(entry.first, "decompress MB/s", before.decompressMBps,
+                                           now.decompressMBps, tolerance, true);
+                regressed |= compareMetric(entry.first, "ratio", before.ratio, now.ratio, ratioTolerance, false);
+            }
+            for (const auto& entry : baseline) {
+                if (results.find(entry.first) == results.end()) {
+                    std::cout << std::left << std::setw(18) << entry.first << "missing from this run" << std::endl;
+                    regressed = true;
+                }
+            }
+            std::cout << (regressed ? "Performance regression detected" : "Performance test passed")
+                      << " (tolerance " << tolerance * 100.0 << "%, ratio tolerance "
+                      << ratioTolerance * 100.0 << "%)" << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        fs::remove_all(workDir);
+        return 1;
+    }
+
+    fs::remove_all(workDir);
+    return regressed ? 1 : 0;
+}